@@ -0,0 +1,108 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+#include "arena.h"
+
+#include <cstdlib>
+using namespace std;
+
+static const size_t FIRST_CHUNK_SIZE = 1 << 16;
+static const size_t MAX_CHUNK_SIZE = 1 << 24;
+static const size_t ALIGNMENT = 16;
+
+class ArenaLock {
+  pthread_mutex_t &mutex;
+public:
+  ArenaLock(pthread_mutex_t &m) : mutex(m) {pthread_mutex_lock(&mutex);}
+  ~ArenaLock() {pthread_mutex_unlock(&mutex);}
+};
+
+Arena::Arena(const char *the_name)
+  : name(the_name), chunk_pos(0), chunk_end(0),
+    next_chunk_size(FIRST_CHUNK_SIZE), allocation_count(0),
+    requested_bytes(0), deallocation_count(0), deallocated_bytes(0),
+    reserved_bytes(0) {
+  pthread_mutex_init(&mutex, 0);
+}
+
+Arena::~Arena() {
+  release();
+  pthread_mutex_destroy(&mutex);
+}
+
+void *Arena::allocate(size_t size) {
+  ArenaLock lock(mutex);
+  allocation_count++;
+  requested_bytes += size;
+  size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+  if(size == 0)
+    size = ALIGNMENT;
+  if(size > size_t(chunk_end - chunk_pos)) {
+    // Large requests get a chunk of their own, so that the rest of
+    // the current chunk is not wasted.
+    if(size > next_chunk_size / 4) {
+      char *chunk = static_cast<char *>(malloc(size));
+      if(!chunk) {
+	cout << "Out of memory in " << name << " arena." << endl;
+	exit(1);
+      }
+      chunks.push_back(chunk);
+      reserved_bytes += size;
+      return chunk;
+    }
+    char *chunk = static_cast<char *>(malloc(next_chunk_size));
+    if(!chunk) {
+      cout << "Out of memory in " << name << " arena." << endl;
+      exit(1);
+    }
+    chunks.push_back(chunk);
+    reserved_bytes += next_chunk_size;
+    chunk_pos = chunk;
+    chunk_end = chunk + next_chunk_size;
+    if(next_chunk_size < MAX_CHUNK_SIZE)
+      next_chunk_size *= 2;
+  }
+  void *result = chunk_pos;
+  chunk_pos += size;
+  return result;
+}
+
+void Arena::deallocate(void *, size_t size) {
+  ArenaLock lock(mutex);
+  deallocation_count++;
+  deallocated_bytes += size;
+}
+
+void Arena::release() {
+  ArenaLock lock(mutex);
+  for(int i = 0; i < chunks.size(); i++)
+    free(chunks[i]);
+  chunks.clear();
+  chunk_pos = chunk_end = 0;
+}
+
+void Arena::report(ostream &out) const {
+  ArenaLock lock(mutex);
+  out << "arena " << name << ": "
+      << allocation_count << " allocations, "
+      << requested_bytes << " bytes requested, "
+      << deallocation_count << " frees (" << deallocated_bytes
+      << " bytes) left to bulk release, "
+      << reserved_bytes << " bytes in " << chunks.size() << " chunks" << endl;
+}
@@ -0,0 +1,148 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+#ifndef ARENA_H
+#define ARENA_H
+
+/*
+  Monotonic memory arenas.
+
+  Preprocessing builds every structure once, writes the output and
+  exits, so most data never needs to be freed on its own. An Arena
+  hands out memory from large chunks and gives all of it back at once
+  when it is released or destroyed; deallocate() only updates the
+  statistics. Objects placed in an arena must not own memory outside
+  of it, since their destructors are not run.
+
+  Each PipelineContext has two arenas: one for data read from the
+  task (it may be used from the parser threads, so all methods lock)
+  and one for the graph structures built from it. Use ArenaAllocator
+  to put STL containers into an arena, and "new(arena) T(...)" for
+  single objects.
+*/
+
+#include "span.h"
+
+#include <pthread.h>
+
+#include <cstddef>
+#include <iostream>
+#include <new>
+#include <vector>
+using namespace std;
+
+class Arena {
+  const char *name;
+  vector<char *> chunks;
+  char *chunk_pos;
+  char *chunk_end;
+  size_t next_chunk_size;
+  mutable pthread_mutex_t mutex;
+
+  // statistics
+  size_t allocation_count;
+  size_t requested_bytes;
+  size_t deallocation_count;
+  size_t deallocated_bytes;
+  size_t reserved_bytes;
+
+  Arena(const Arena &copy);
+  Arena &operator=(const Arena &copy);
+public:
+  explicit Arena(const char *name);
+  ~Arena();
+
+  void *allocate(size_t size);
+  void deallocate(void *ptr, size_t size);
+  // Frees all chunks; everything allocated so far becomes invalid.
+  void release();
+  void report(ostream &out) const;
+
+  template<class T>
+  T *allocate_array(size_t count) {
+    return static_cast<T *>(allocate(count * sizeof(T)));
+  }
+  // Copies the elements into the arena.
+  template<class T>
+  Span<T> copy(const vector<T> &elements) {
+    if(elements.empty())
+      return Span<T>();
+    T *data = allocate_array<T>(elements.size());
+    for(size_t i = 0; i < elements.size(); i++)
+      new(data + i) T(elements[i]);
+    return Span<T>(data, data + elements.size());
+  }
+};
+
+inline void *operator new(size_t size, Arena &arena) {
+  return arena.allocate(size);
+}
+
+inline void operator delete(void *ptr, Arena &arena) {
+  // only called if a constructor throws
+  arena.deallocate(ptr, 0);
+}
+
+template<class T>
+class ArenaAllocator {
+public:
+  typedef T value_type;
+  typedef T *pointer;
+  typedef const T *const_pointer;
+  typedef T &reference;
+  typedef const T &const_reference;
+  typedef size_t size_type;
+  typedef ptrdiff_t difference_type;
+  template<class U>
+  struct rebind {
+    typedef ArenaAllocator<U> other;
+  };
+
+  Arena *arena;
+
+  ArenaAllocator(Arena &the_arena) : arena(&the_arena) {}
+  template<class U>
+  ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+  pointer address(reference x) const {return &x;}
+  const_pointer address(const_reference x) const {return &x;}
+  pointer allocate(size_type n, const void * = 0) {
+    return arena->allocate_array<T>(n);
+  }
+  void deallocate(pointer p, size_type n) {
+    arena->deallocate(p, n * sizeof(T));
+  }
+  size_type max_size() const {return size_t(-1) / sizeof(T);}
+  void construct(pointer p, const T &value) {
+    new(static_cast<void *>(p)) T(value);
+  }
+  void destroy(pointer p) {p->~T();}
+};
+
+template<class T, class U>
+bool operator==(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena == b.arena;
+}
+
+template<class T, class U>
+bool operator!=(const ArenaAllocator<T> &a, const ArenaAllocator<U> &b) {
+  return a.arena != b.arena;
+}
+
+#endif
@@ -21,41 +21,79 @@
  *********************************************************************/
 
 #include "helper_functions.h"
+#include "arena.h"
 #include "axiom.h"
+#include "pipeline_context.h"
 #include "variable.h"
+#include "tokenizer.h"
+#include "sas_binary.h"
 
 #include <iostream>
 #include <fstream>
 #include <cassert>
 using namespace std;
 
-Axiom::Axiom(istream &in, const vector<Variable *> &variables) {
-  check_magic(in, "begin_rule");
-  int count; // number of conditions
-  in >> count;
+Axiom::Axiom(Tokenizer &in, const vector<Variable *> &variables,
+	     Arena &arena) {
+  in.check_magic("begin_rule");
+  int count = in.read_int(); // number of conditions
+  Condition *data = arena.allocate_array<Condition>(count);
   for(int i = 0; i < count; i++) {
-    int varNo, val;
-    in >> varNo >> val;
-    conditions.push_back(Condition(variables[varNo], val));
+    int varNo = in.read_int();
+    int val = in.read_int();
+    new(data + i) Condition(variables[varNo], val);
   }
-  int varNo, oldVal, newVal;
-  in >> varNo >> oldVal >> newVal;
+  conditions = Span<Condition>(data, data + count);
+  int varNo = in.read_int();
+  int oldVal = in.read_int();
+  int newVal = in.read_int();
   effect_var = variables[varNo];
   old_val = oldVal;
   effect_val = newVal;
-  check_magic(in, "end_rule");
+  in.check_magic("end_rule");
 }
 
-bool Axiom::is_redundant() const {
-  return effect_var->get_level() == -1;
+Axiom::Axiom(BinaryReader &in, const vector<Variable *> &variables,
+	     Arena &arena) {
+  int count = in.read_count();
+  Condition *data = arena.allocate_array<Condition>(count);
+  for(int i = 0; i < count; i++) {
+    Variable *var = in.read_variable(variables);
+    int val = in.read_int();
+    new(data + i) Condition(var, val);
+  }
+  conditions = Span<Condition>(data, data + count);
+  effect_var = in.read_variable(variables);
+  old_val = in.read_int();
+  effect_val = in.read_int();
+}
+
+void Axiom::write_binary(BinaryWriter &out) const {
+  out.write_uint(conditions.size());
+  for(int i = 0; i < conditions.size(); i++) {
+    out.write_uint(conditions[i].var->get_index());
+    out.write_int(conditions[i].cond);
+  }
+  out.write_uint(effect_var->get_index());
+  out.write_int(old_val);
+  out.write_int(effect_val);
+}
+
+bool Axiom::is_redundant(const PipelineContext &context) const {
+  return context.get_level(effect_var) == -1;
 }
 
-void strip_axioms(vector<Axiom> &axioms) {
+void strip_axioms(const PipelineContext &context, vector<Axiom> &axioms) {
   int old_count = axioms.size();
   int new_index = 0;
+  // Axioms only hold a span of their conditions, so moving one down is
+  // cheap; the kept prefix is not touched at all.
   for(int i = 0; i < axioms.size(); i++)
-    if(!axioms[i].is_redundant())
-      axioms[new_index++] = axioms[i];
+    if(!axioms[i].is_redundant(context)) {
+      if(new_index != i)
+	axioms[new_index] = axioms[i];
+      new_index++;
+    }
   axioms.erase(axioms.begin() + new_index, axioms.end());
   cout << axioms.size() << " of " << old_count << " axiom rules necessary." << endl;
 }
@@ -71,14 +109,15 @@ void Axiom::dump() const {
   cout << endl;
 }
 
-void Axiom::generate_cpp_input(ofstream &outfile) const {
-  assert(effect_var->get_level() != -1);
+void Axiom::generate_cpp_input(ofstream &outfile,
+			       const PipelineContext &context) const {
+  assert(context.get_level(effect_var) != -1);
   outfile << "begin_rule" << endl;
   outfile << conditions.size() << endl;
   for(int i = 0; i < conditions.size(); i++) {
-    assert(conditions[i].var->get_level() != -1);
-    outfile << conditions[i].var->get_level() << " "<< conditions[i].cond << endl;
+    assert(context.get_level(conditions[i].var) != -1);
+    outfile << context.get_level(conditions[i].var) << " "<< conditions[i].cond << endl;
   }
-  outfile << effect_var->get_level() << " " << old_val << " " << effect_val << endl;
+  outfile << context.get_level(effect_var) << " " << old_val << " " << effect_val << endl;
   outfile << "end_rule" << endl;
 }
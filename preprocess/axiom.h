@@ -23,12 +23,19 @@
 #ifndef AXIOM_H
 #define AXIOM_H
 
+#include "span.h"
+
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <vector>
 using namespace std;
 
+class Arena;
+class BinaryReader;
+class BinaryWriter;
+class PipelineContext;
+class Tokenizer;
 class Variable;
 
 class Axiom {
@@ -42,19 +49,24 @@ private:
   Variable *effect_var;
   int old_val; 
   int effect_val;
-  vector<Condition> conditions;      // var, val
+  Span<Condition> conditions;      // var, val; in the task arena
 public:
-  Axiom(istream &in, const vector<Variable *> &variables);
+  // The conditions are allocated in the arena.
+  Axiom(Tokenizer &in, const vector<Variable *> &variables, Arena &arena);
+  Axiom(BinaryReader &in, const vector<Variable *> &variables, Arena &arena);
+  void write_binary(BinaryWriter &out) const;
 
-  bool is_redundant() const;
+  bool is_redundant(const PipelineContext &context) const;
   void dump() const;
-  void generate_cpp_input(ofstream &outfile) const;
-  const vector<Condition> &get_conditions() const {return conditions;}
+  void generate_cpp_input(ofstream &outfile,
+			  const PipelineContext &context) const;
+  Span<Condition> get_conditions() const {return conditions;}
   Variable* get_effect_var() const {return effect_var;}
   int get_old_val() const {return old_val;}
   int get_effect_val() const {return effect_val;}
 };
 
-extern void strip_axioms(vector<Axiom> &axioms);
+extern void strip_axioms(const PipelineContext &context,
+			 vector<Axiom> &axioms);
 
 #endif
@@ -48,17 +48,18 @@
 #include "max_dag.h"
 #include "operator.h"
 #include "axiom.h"
+#include "pipeline_context.h"
 #include "scc.h"
 #include "variable.h"
 
+#include <algorithm>
 #include <iostream>
 #include <cassert>
+#include <climits>
 using namespace std;
 
-bool g_do_not_prune_variables = false;
-
 void CausalGraph::weigh_graph_from_ops(const vector<Variable *> &,
-				       const vector<Operator> &operators,
+				       const OperatorTable &operators,
 				       const vector<pair<Variable *, int> >&){
 
 	// For each operator
@@ -66,61 +67,38 @@ void CausalGraph::weigh_graph_from_ops(const vector<Variable *> &,
 
 	// Get vectors of prevail and prepost
 	// prevail: Variable var*, int pre
-	// pre_post: Variable *var; int pre, post; float f_cost; bool is_conditional_effect; vector<EffCond> effect_conds;
-	// vector<EffCond> effect_conds: Variable *var; int cond;
-	const vector<Operator::Prevail> &prevail = operators[i].get_prevail();
-    const vector<Operator::PrePost> &pre_post = operators[i].get_pre_post();
+	// pre_post: Variable *var; int pre, post; float f_cost; bool is_conditional_effect;
+	// get_effect_conds(pre_post): Variable *var; int cond;
+	Operator op = operators[i];
+	Span<Operator::Prevail> prevail = op.get_prevail();
+    Span<Operator::PrePost> pre_post = op.get_pre_post();
 
     // Sources are the origin states from prevail and prepost effects
-    vector<Variable *> source_vars;
+    vector<int> source_vars;
     for(int j = 0; j < prevail.size(); j++)
-      source_vars.push_back(prevail[j].var);
+      source_vars.push_back(prevail[j].var->get_index());
     for(int j = 0; j < pre_post.size(); j++)
       if(pre_post[j].pre != -1)
-	source_vars.push_back(pre_post[j].var);
+	source_vars.push_back(pre_post[j].var->get_index());
 
     // For effect in pre_post -> the origin is target
     for(int k = 0; k < pre_post.size(); k++) {
-      Variable *curr_target = pre_post[k].var;
-  	if (curr_target == NULL)
-  		printf("asdasa");
+      int curr_target = pre_post[k].var->get_index();
 
       // Conditions from conditional effects are also source vars for this target
+      Span<Operator::EffCond> effect_conds = op.get_effect_conds(pre_post[k]);
       if(pre_post[k].is_conditional_effect)
-	for(int l = 0; l < pre_post[k].effect_conds.size(); l++)
-	  source_vars.push_back(pre_post[k].effect_conds[l].var);
-
-      // For each source, get var and declare successors
-      for(int j = 0; j < source_vars.size(); j++) {
-	Variable *curr_source = source_vars[j];
-	if (curr_source == NULL)
-		printf("asdasa");
-	WeightedSuccessors &weighted_succ = weighted_graph[curr_source];
-
-	// predecessor_graph is weighted_graph with edges turned around
-	// If the target does not have predecessors, declare them
-	if(predecessor_graph.count(curr_target) == 0)
-	  predecessor_graph[curr_target] = Predecessors();
-	// If the source and the target Var are different,
-	if(curr_source != curr_target) {
-	    // and the connection has been already added
-	  if(weighted_succ.find(curr_target) != weighted_succ.end()){
-		  // increase weight
-	    weighted_succ[curr_target]++;
-	    predecessor_graph[curr_target][curr_source]++;
-	  }
-	  // and the connection has not been already added
-	  else{
-		  // set weight = 1
-	    weighted_succ[curr_target] = 1;
-	    predecessor_graph[curr_target][curr_source] = 1;
-	  }
-	}
-      }
+	for(int l = 0; l < effect_conds.size(); l++)
+	  source_vars.push_back(effect_conds[l].var->get_index());
+
+      // Each (source, target) occurrence adds one to the edge weight.
+      for(int j = 0; j < source_vars.size(); j++)
+	if(source_vars[j] != curr_target)
+	  arcs.push_back(make_pair(source_vars[j], curr_target));
 
       // remove the conditional sources that were added for this target
       if(pre_post[k].is_conditional_effect)
-	source_vars.erase(source_vars.end() - pre_post[k].effect_conds.size(),
+	source_vars.erase(source_vars.end() - effect_conds.size(),
 			  source_vars.end());
     }
   }
@@ -130,47 +108,51 @@ void CausalGraph::weigh_graph_from_axioms(const vector<Variable *> &,
 					  const vector<Axiom> &axioms,
 					  const vector<pair<Variable *, int> >&){
   for(int i = 0; i < axioms.size(); i++) {
-    const vector<Axiom::Condition> &conds = axioms[i].get_conditions();
-    vector<Variable *> source_vars;
-    for(int j = 0; j < conds.size(); j++)
-      source_vars.push_back(conds[j].var);
-
-    for(int j = 0; j < source_vars.size(); j++) {
-      Variable *curr_source = source_vars[j];
-      WeightedSuccessors &weighted_succ = weighted_graph[curr_source];
-      // only one target var: the effect var of axiom[i]
-      Variable *curr_target = axioms[i].get_effect_var();
-      if(predecessor_graph.count(curr_target) == 0)
-	predecessor_graph[curr_target] = Predecessors();
-      if(curr_source != curr_target) {
-	if(weighted_succ.find(curr_target) != weighted_succ.end()){
-	  weighted_succ[curr_target]++;
-	  predecessor_graph[curr_target][curr_source]++;
-	}
-	else{
-	  weighted_succ[curr_target] = 1;
-	  predecessor_graph[curr_target][curr_source] = 1;
-	}
-      }
+    Span<Axiom::Condition> conds = axioms[i].get_conditions();
+    // only one target var: the effect var of axiom[i]
+    int curr_target = axioms[i].get_effect_var()->get_index();
+    for(int j = 0; j < conds.size(); j++) {
+      int curr_source = conds[j].var->get_index();
+      if(curr_source != curr_target)
+	arcs.push_back(make_pair(curr_source, curr_target));
+    }
+  }
+}
+
+void CausalGraph::build_adjacency() {
+  // Sorting groups equal arcs, so the weight of an edge is the length
+  // of its run, and leaves the successors of each source ordered.
+  sort(arcs.begin(), arcs.end());
+  int var_count = variables.size();
+  successors.clear();
+  successors.reserve(var_count, arcs.size());
+  int i = 0;
+  for(int source = 0; source < var_count; source++) {
+    while(i < arcs.size() && arcs[i].first == source) {
+      int j = i + 1;
+      while(j < arcs.size() && arcs[j] == arcs[i])
+	j++;
+      successors.add_arc(arcs[i].second, j - i);
+      i = j;
     }
+    successors.finish_node();
   }
+  predecessors.assign_reverse(successors);
+  vector<pair<int, int> >().swap(arcs);
 }
 
 
-CausalGraph::CausalGraph(const vector<Variable *> &the_variables,
-			 const vector<Operator> &the_operators,
+CausalGraph::CausalGraph(PipelineContext &the_context,
+			 const vector<Variable *> &the_variables,
+			 const OperatorTable &the_operators,
 			 const vector<Axiom> &the_axioms,
 			 const vector<pair<Variable *, int> > &the_goals)
   
-  : variables(the_variables), operators(the_operators), axioms(the_axioms),
-    goals(the_goals), acyclic(false) {
-  // Weighted graph is a map [variable *, WeightedSuccessors]
-  // WeightedSuccessors is a map [variable *, int]
-  for(int i = 0; i < variables.size(); i++)
-    weighted_graph[variables[i]] = WeightedSuccessors();
-  // Both predecessor_graph and weighted_graph are created now
+  : context(the_context), variables(the_variables), operators(the_operators),
+    axioms(the_axioms), goals(the_goals), acyclic(false) {
   weigh_graph_from_ops(variables, operators, goals);
   weigh_graph_from_axioms(variables, axioms, goals);
+  build_adjacency();
   //dump();
 
   // Partition: typedef vector<vector<Variable *> >
@@ -200,48 +182,70 @@ CausalGraph::CausalGraph(const vector<Variable *> &the_variables,
    cout << endl;
 }
 
+// Computes the subgraph induced by the component (arcs into goal
+// variables are added a second time with a bonus weight) and appends
+// the variables of the component to ordering in the order MaxDAG finds.
+template<class Index>
+static void order_component(const vector<Variable *> &curr_scc,
+			    const CompactGraph<unsigned int> &successors,
+			    const vector<int> &index_in_scc,
+			    const vector<bool> &is_goal,
+			    CompactGraph<Index> &subgraph,
+			    MaxDAG<Index> &max_dag,
+			    vector<int> &order,
+			    vector<Variable *> &ordering) {
+  subgraph.clear();
+  for(int i = 0; i < curr_scc.size(); i++) {
+    // For each variable in component only list edges inside component.
+    int source = curr_scc[i]->get_index();
+    for(int j = successors.begin(source); j < successors.end(source); j++) {
+      int target = successors.get_target(j);
+      int cost = successors.get_weight(j);
+      int new_index = index_in_scc[target];
+      if(new_index != -1) {
+	if(is_goal[target]) {
+	  // target is goal
+	  subgraph.add_arc(new_index, 100000 + cost);
+	}
+	subgraph.add_arc(new_index, cost);
+      }
+    }
+    subgraph.finish_node();
+  }
+
+  max_dag.get_result(subgraph, order);
+  for(int i = 0; i < order.size(); i++) {
+    ordering.push_back(curr_scc[order[i]]);	
+  }	
+}
+
 void CausalGraph::calculate_topological_pseudo_sort(const Partition &sccs) {
-  map<Variable *, int> goal_map;
+  vector<bool> is_goal(variables.size(), false);
   for(int i = 0; i < goals.size(); i++)
-    goal_map[goals[i].first] = goals[i].second;
+    is_goal[goals[i].first->get_index()] = true;
+  // Position of each variable in the component being ordered, -1 for
+  // variables outside of it.
+  vector<int> index_in_scc(variables.size(), -1);
+  // Most components are small enough for 16 bit node ids.
+  CompactGraph<unsigned short> small_subgraph;
+  MaxDAG<unsigned short> small_max_dag;
+  CompactGraph<unsigned int> subgraph;
+  MaxDAG<unsigned int> max_dag;
+  vector<int> order;
   for(int scc_no = 0; scc_no < sccs.size(); scc_no++) {
     const vector<Variable *> &curr_scc = sccs[scc_no];
     if(curr_scc.size() > 1) {
       // component needs to be turned into acyclic subgraph  
-
-      // Map variables to indices in the strongly connected component.
-      map<Variable *, int> variableToIndex;
       for(int i = 0; i < curr_scc.size(); i++)
-	variableToIndex[curr_scc[i]] = i;
-
-      // Compute subgraph induced by curr_scc and convert the successor
-      // representation from a map to a vector.
-      vector<vector<pair<int, int> > > subgraph;
-      for(int i = 0; i < curr_scc.size(); i++) {
-	// For each variable in component only list edges inside component.
-	WeightedSuccessors &all_edges = weighted_graph[curr_scc[i]];
-	vector<pair<int, int> > subgraph_edges;
-	for(WeightedSuccessors::const_iterator curr = all_edges.begin();
-	    curr != all_edges.end(); ++curr) {
-	  Variable *target = curr->first;
-	  int cost = curr->second;
-	  map<Variable *, int>::iterator index_it = variableToIndex.find(target);
-	  if(index_it != variableToIndex.end()) {
-	    int new_index = index_it->second;
-	    if(goal_map.find(target) != goal_map.end()) {
-	      // target is goal
-	      subgraph_edges.push_back(make_pair(new_index, 100000 + cost));
-	    }
-	    subgraph_edges.push_back(make_pair(new_index, cost));
-	  }
-	}
-	subgraph.push_back(subgraph_edges);
-      }
-      
-      vector<int> order = MaxDAG(subgraph).get_result();
-      for(int i = 0; i < order.size(); i++) {
-	ordering.push_back(curr_scc[order[i]]);	
-      }	
+	index_in_scc[curr_scc[i]->get_index()] = i;
+      if(CompactGraph<unsigned short>::fits(curr_scc.size()))
+	order_component(curr_scc, successors, index_in_scc, is_goal,
+			small_subgraph, small_max_dag, order, ordering);
+      else
+	order_component(curr_scc, successors, index_in_scc, is_goal,
+			subgraph, max_dag, order, ordering);
+      for(int i = 0; i < curr_scc.size(); i++)
+	index_in_scc[curr_scc[i]->get_index()] = -1;
     } else {
       ordering.push_back(curr_scc[0]);
     }
@@ -249,74 +253,88 @@ void CausalGraph::calculate_topological_pseudo_sort(const Partition &sccs) {
 }
 
 void CausalGraph::get_strongly_connected_components(Partition &result) {
-  // Create map Variable*, index
-  map<Variable *, int> variableToIndex;
-  for(int i = 0; i < variables.size(); i++)
-    variableToIndex[variables[i]] = i;
-
-  // unweighted_graph : vector<vector<int> > of variables size
-  vector<vector<int> > unweighted_graph;
-  unweighted_graph.resize(variables.size());
-
-  // Iterate over weighted graph
-  for(WeightedGraph::const_iterator it = weighted_graph.begin();
-      it != weighted_graph.end(); ++it) {
-
-	// get index of the variable
-    int index = variableToIndex[it->first];
-    // Create vector of successors
-    vector<int> &succ = unweighted_graph[index];
-    // Iterate over the successors and add them
-    const WeightedSuccessors &weighted_succ = it->second;
-    for(WeightedSuccessors::const_iterator it = weighted_succ.begin(); 
-	it != weighted_succ.end(); ++it)
-      succ.push_back(variableToIndex[it->first]);
-  }
-
-  // SCC contructor needs a graph
-  // int_result is a list of stacks of successor vertex with the minimum depth possible
-  vector<vector<int> > int_result = SCC(unweighted_graph).get_result();
+  // The components are flattened: component i is
+  // vertices[offsets[i]] .. vertices[offsets[i + 1] - 1]
+  vector<int> vertices, offsets;
+  SCC<unsigned int>().get_result(successors, vertices, offsets);
 
   result.clear();
+  result.resize(offsets.size() - 1);
   // For each scc
-  for(int i = 0; i < int_result.size(); i++) {
-    vector<Variable *> component;
-    // Iterate over the stack and create a vector of variables strongly connected -> from int to Var
-    for(int j = 0; j < int_result[i].size(); j++)
-      component.push_back(variables[int_result[i][j]]);
-    result.push_back(component);
+  for(int i = 0; i + 1 < offsets.size(); i++) {
+    // Create a vector of variables strongly connected -> from int to Var
+    vector<Variable *> &component = result[i];
+    for(int j = offsets[i]; j < offsets[i + 1]; j++)
+      component.push_back(variables[vertices[j]]);
   }
 }
 void CausalGraph::calculate_important_vars() {
-  for(int i = 0; i < goals.size(); i++){
-    if(!goals[i].first->is_necessary()){
-      //cout << "var " << goals[i].first->get_name() <<" is directly neccessary." 
-      // << endl;
-      goals[i].first->set_necessary();
-      dfs(goals[i].first);
-    }
-  }
+  vector<vector<int> > goal_sets(1);
+  for(int i = 0; i < goals.size(); i++)
+    goal_sets[0].push_back(goals[i].first->get_index());
+  vector<unsigned long> relevant;
+  calculate_relevance(goal_sets, relevant);
+  for(int i = 0; i < variables.size(); i++)
+    if(relevant[i])
+      context.set_necessary(variables[i]);
   // change ordering to leave out unimportant vars
   vector<Variable *> new_ordering;
   int old_size = ordering.size();
   for(int i = 0; i < old_size; i++)
-    if(ordering[i]->is_necessary() || g_do_not_prune_variables)
+    if(context.is_necessary(ordering[i]) ||
+       context.get_do_not_prune_variables())
       new_ordering.push_back(ordering[i]);
   ordering = new_ordering;
   for(int i = 0; i < ordering.size(); i++) {
-    ordering[i]->set_level(i);
+    context.set_level(ordering[i], i);
   }
   cout << ordering.size() << " variables of " << old_size << " necessary" << endl;
 }
 
-void CausalGraph::dfs(Variable *from) {
-  for(Predecessors::iterator pred = predecessor_graph[from].begin();
-      pred != predecessor_graph[from].end(); ++pred){
-    Variable* curr_predecessor = pred->first;
-    if(!curr_predecessor->is_necessary()){
-      curr_predecessor->set_necessary();
-      //cout << "var " << curr_predecessor->get_name() <<" is neccessary." << endl;
-      dfs(curr_predecessor);
+void CausalGraph::calculate_relevance(const vector<vector<int> > &goal_sets,
+				      vector<unsigned long> &relevant) const {
+  const int lane_bits = sizeof(unsigned long) * CHAR_BIT;
+  int words = (goal_sets.size() + lane_bits - 1) / lane_bits;
+  relevant.assign(variables.size() * words, 0);
+  if(words == 0)
+    return;
+
+  // Worklist of the variables whose bits have not been passed on to
+  // their predecessors yet; each variable is in it at most once.
+  vector<int> open;
+  vector<bool> is_open(variables.size(), false);
+  for(int lane = 0; lane < goal_sets.size(); lane++) {
+    unsigned long bit = 1UL << (lane % lane_bits);
+    for(int i = 0; i < goal_sets[lane].size(); i++) {
+      int goal_var = goal_sets[lane][i];
+      relevant[goal_var * words + lane / lane_bits] |= bit;
+      if(!is_open[goal_var]) {
+	is_open[goal_var] = true;
+	open.push_back(goal_var);
+      }
+    }
+  }
+
+  // Propagate backwards along the arcs until nothing changes.
+  while(!open.empty()) {
+    int from = open.back();
+    open.pop_back();
+    is_open[from] = false;
+    for(int i = predecessors.begin(from); i < predecessors.end(from); i++) {
+      int predecessor = predecessors.get_target(i);
+      bool changed = false;
+      for(int w = 0; w < words; w++) {
+	unsigned long new_bits = relevant[from * words + w] &
+	  ~relevant[predecessor * words + w];
+	if(new_bits) {
+	  relevant[predecessor * words + w] |= new_bits;
+	  changed = true;
+	}
+      }
+      if(changed && !is_open[predecessor]) {
+	is_open[predecessor] = true;
+	open.push_back(predecessor);
+      }
     }
   }
 }
@@ -330,63 +348,37 @@ bool CausalGraph::is_acyclic() const {
 }
 
 void CausalGraph::dump() const {
-  for(WeightedGraph::const_iterator source = weighted_graph.begin();
-      source != weighted_graph.end(); ++source) {
-    cout << "dependent on var " << source->first->get_name() << ": " << endl;
-    const WeightedSuccessors &curr = source->second;
-    for(WeightedSuccessors::const_iterator it = curr.begin(); 
-	it != curr.end(); ++it){
-      cout << "  [" << it->first->get_name() << ", " << it->second << "]" << endl;
-      //assert(predecessor_graph[it->first][source->first] == it->second); 
-    }
+  for(int source = 0; source < variables.size(); source++) {
+    cout << "dependent on var " << variables[source]->get_name() << ": " << endl;
+    for(int i = successors.begin(source); i < successors.end(source); i++)
+      cout << "  [" << variables[successors.get_target(i)]->get_name() << ", "
+	   << successors.get_weight(i) << "]" << endl;
   }
-  for(PredecessorGraph::const_iterator source = predecessor_graph.begin();
-      source != predecessor_graph.end(); ++source) {
-    cout << "var " << source->first->get_name() << " is dependent of: " << endl;
-    const Predecessors &curr = source->second;
-    for(Predecessors::const_iterator it = curr.begin(); 
-	it != curr.end(); ++it)
-      cout << "  [" << it->first->get_name() << ", " << it->second << "]" << endl; 
+  for(int target = 0; target < variables.size(); target++) {
+    cout << "var " << variables[target]->get_name() << " is dependent of: " << endl;
+    for(int i = predecessors.begin(target); i < predecessors.end(target); i++)
+      cout << "  [" << variables[predecessors.get_target(i)]->get_name() << ", "
+	   << predecessors.get_weight(i) << "]" << endl; 
   }
 }
 void CausalGraph::generate_cpp_input(ofstream &outfile,
 				     const vector<Variable *> & ordered_vars) 
   const {
-  vector<WeightedSuccessors *> succs; // will be ordered like ordered_vars
-  vector<int> number_of_succ; // will be ordered like ordered_vars
-  succs.resize(ordered_vars.size());
-  number_of_succ.resize(ordered_vars.size());
-  for(WeightedGraph::const_iterator source = weighted_graph.begin();
-      source != weighted_graph.end(); ++source) {
-    Variable * source_var = source->first;
-    if(source_var->get_level() != -1) {
-      // source variable influences others 
-      WeightedSuccessors &curr = (WeightedSuccessors &) source->second;
-      succs[source_var->get_level()] = &curr; 
-      // count number of influenced vars
-      int num = 0;
-      for(WeightedSuccessors::const_iterator it = curr.begin(); 
-	it != curr.end(); ++it)
-	if(it->first->get_level() != -1
-	   // && it->first->get_level() > source_var->get_level()
-	   )
-	  num++;
-      number_of_succ[source_var->get_level()] = num;
-    }
-  }
   for(int i = 0; i < ordered_vars.size(); i++) {
-    WeightedSuccessors *curr = succs[i];
+    int source = ordered_vars[i]->get_index();
+    // count number of influenced vars
+    int num = 0;
+    for(int j = successors.begin(source); j < successors.end(source); j++)
+      if(context.get_level(variables[successors.get_target(j)]) != -1)
+	num++;
     // print number of variables influenced by variable i
-    outfile << number_of_succ[i] << endl;
-    for(WeightedSuccessors::const_iterator it = curr->begin(); 
-      it != curr->end(); ++it){
-      if(it->first->get_level() != -1
-	 // && it->first->get_level() > ordered_vars[i]->get_level()
-	 ) 
-        // the variable it->first is important and influenced by variable i
+    outfile << num << endl;
+    for(int j = successors.begin(source); j < successors.end(source); j++) {
+      const Variable *target = variables[successors.get_target(j)];
+      if(context.get_level(target) != -1)
+        // the variable target is important and influenced by variable i
         // print level and weight of influence
-	outfile << it->first->get_level() << " "<< it->second << endl;
+	outfile << context.get_level(target) << " "<< successors.get_weight(j) << endl;
     }
   }
 }
-
@@ -23,28 +23,32 @@
 #ifndef CAUSAL_GRAPH_H
 #define CAUSAL_GRAPH_H
 
+#include "compact_graph.h"
+
 #include <vector>
-#include <map>
 #include <fstream>
 using namespace std;
 
-class Operator;
+class OperatorTable;
+class PipelineContext;
 class Axiom;
 class Variable;
 
 class CausalGraph {
+  PipelineContext &context;
   const vector<Variable *> &variables;
-  const vector<Operator> &operators;
+  const OperatorTable &operators;
   const vector<Axiom> &axioms;
   const vector<pair<Variable *, int> > &goals;
 
-  typedef map<Variable *, int> WeightedSuccessors;
-  typedef map<Variable *, WeightedSuccessors> WeightedGraph;
-  WeightedGraph weighted_graph;
-  typedef map<Variable *, int> Predecessors;
-  typedef map<Variable *, Predecessors> PredecessorGraph;
-  // predecessor_graph is weighted_graph with edges turned around
-  PredecessorGraph predecessor_graph;
+  // The graph is stored over variable indices: the arcs leaving
+  // variable v are sorted by target and weighted by the number of
+  // dependencies. predecessors holds the same arcs turned around.
+  CompactGraph<unsigned int> successors;
+  CompactGraph<unsigned int> predecessors;
+  // (source, target) pair per operator or axiom dependency, before
+  // they are counted into the arrays above
+  vector<pair<int, int> > arcs;
 
   typedef vector<vector<Variable *> > Partition;
   typedef vector<Variable *> Ordering;
@@ -52,28 +56,35 @@ class CausalGraph {
   bool acyclic;
 
   void weigh_graph_from_ops(const vector<Variable *> &variables,
-			    const vector<Operator> &operators,
+			    const OperatorTable &operators,
 			    const vector<pair<Variable *, int> > &goals);
   void weigh_graph_from_axioms(const vector<Variable *> &variables,
 			       const vector<Axiom> &axioms,
 			       const vector<pair<Variable *, int> > &goals);
+  void build_adjacency();
   void get_strongly_connected_components(Partition &sccs);
   void calculate_topological_pseudo_sort(const Partition &sccs);
   void calculate_important_vars();
-  void dfs(Variable *from);
 public:
-  CausalGraph(const vector<Variable *> &variables,
-	      const vector<Operator> &operators,
+  // Sets the levels and necessary variables in the context.
+  CausalGraph(PipelineContext &context,
+	      const vector<Variable *> &variables,
+	      const OperatorTable &operators,
 	      const vector<Axiom> &axioms,
 	      const vector<pair<Variable *, int> > &the_goals);
   ~CausalGraph() {}
   const vector<Variable *> &get_variable_ordering() const;
   bool is_acyclic() const;
+  // Computes the variables relevant for several goal sets in one sweep.
+  // A variable is relevant for a goal set if it has a path to one of its
+  // variables (given by index). Goal set k is bit k % BITS of word
+  // k / BITS, where BITS is the number of bits in an unsigned long; each
+  // variable has one run of words in relevant, in index order.
+  void calculate_relevance(const vector<vector<int> > &goal_sets,
+			   vector<unsigned long> &relevant) const;
   void dump() const;
   void generate_cpp_input(ofstream &outfile, 
 			  const vector<Variable *> & ordered_vars) const;
 };
 
-extern bool g_do_not_prune_variables;
-
 #endif
@@ -0,0 +1,109 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+
+#ifndef COMPACT_GRAPH_H
+#define COMPACT_GRAPH_H
+
+/*
+  Directed graph in compressed sparse row form, with node ids stored in
+  Index (unsigned short for small graphs such as DTGs, unsigned int
+  otherwise). The arcs leaving node v are arcs begin(v) .. end(v) - 1;
+  get_target() and get_weight() look them up. Weights are optional.
+
+  A graph is built node by node: add the arcs leaving node 0, call
+  finish_node(), and so on. clear() keeps the allocated memory, so one
+  graph can be rebuilt many times without allocating.
+*/
+
+#include <cassert>
+#include <limits>
+#include <vector>
+using namespace std;
+
+template<class Index>
+class CompactGraph {
+  vector<int> offsets;
+  vector<Index> targets;
+  vector<int> weights;
+  vector<int> next; // scratch for assign_reverse
+public:
+  CompactGraph() : offsets(1, 0) {}
+
+  // Whether node ids 0 .. node_count - 1 fit into Index.
+  static bool fits(int node_count) {
+    return node_count == 0 ||
+      (unsigned long) (node_count - 1) <= numeric_limits<Index>::max();
+  }
+
+  void clear() {
+    offsets.assign(1, 0);
+    targets.clear();
+    weights.clear();
+  }
+  void reserve(int node_count, int arc_count) {
+    offsets.reserve(node_count + 1);
+    targets.reserve(arc_count);
+  }
+  void add_arc(int target) {
+    assert(weights.empty());
+    targets.push_back(static_cast<Index>(target));
+  }
+  void add_arc(int target, int weight) {
+    assert(weights.size() == targets.size());
+    targets.push_back(static_cast<Index>(target));
+    weights.push_back(weight);
+  }
+  void finish_node() {
+    offsets.push_back(targets.size());
+  }
+
+  // Makes this graph the reverse of graph, which must be completely
+  // built. The arcs entering a node come out sorted by source.
+  void assign_reverse(const CompactGraph &graph) {
+    int node_count = graph.get_node_count();
+    bool weighted = graph.is_weighted();
+    offsets.assign(node_count + 1, 0);
+    for(int i = 0; i < graph.targets.size(); i++)
+      offsets[graph.targets[i] + 1]++;
+    for(int v = 0; v < node_count; v++)
+      offsets[v + 1] += offsets[v];
+    targets.resize(graph.targets.size());
+    weights.resize(weighted ? graph.targets.size() : 0);
+    next.assign(offsets.begin(), offsets.end() - 1);
+    for(int source = 0; source < node_count; source++) {
+      for(int i = graph.begin(source); i < graph.end(source); i++) {
+	int pos = next[graph.targets[i]]++;
+	targets[pos] = static_cast<Index>(source);
+	if(weighted)
+	  weights[pos] = graph.weights[i];
+      }
+    }
+  }
+
+  int get_node_count() const {return offsets.size() - 1;}
+  int get_arc_count() const {return targets.size();}
+  bool is_weighted() const {return !weights.empty();}
+  int begin(int node) const {return offsets[node];}
+  int end(int node) const {return offsets[node + 1];}
+  int get_target(int arc) const {return targets[arc];}
+  int get_weight(int arc) const {return weights[arc];}
+};
+
+#endif
@@ -0,0 +1,106 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+#include "condition_table.h"
+#include "arena.h"
+
+#include <algorithm>
+using namespace std;
+
+// FNV-1a over the values of the pairs
+static size_t hash_facts(const vector<ConditionTable::Fact> &facts) {
+  size_t hash = 2166136261u;
+  for(size_t i = 0; i < facts.size(); i++) {
+    hash ^= (size_t) facts[i].first;
+    hash *= 16777619u;
+    hash ^= (size_t) facts[i].second;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+class ConditionTableLock {
+  pthread_mutex_t &mutex;
+public:
+  ConditionTableLock(pthread_mutex_t &m) : mutex(m) {pthread_mutex_lock(&mutex);}
+  ~ConditionTableLock() {pthread_mutex_unlock(&mutex);}
+};
+
+ConditionTable::ConditionTable(Arena &the_arena)
+  : arena(the_arena), total_facts(0) {
+  pthread_mutex_init(&mutex, 0);
+  buckets.resize(1024, -1);
+  vector<Fact> empty;
+  intern(empty);
+}
+
+ConditionTable::~ConditionTable() {
+  pthread_mutex_destroy(&mutex);
+}
+
+void ConditionTable::grow_buckets() {
+  buckets.assign(buckets.size() * 2, -1);
+  size_t mask = buckets.size() - 1;
+  for(int id = 0; id < entries.size(); id++) {
+    size_t bucket = entries[id].hash & mask;
+    while(buckets[bucket] != -1)
+      bucket = (bucket + 1) & mask;
+    buckets[bucket] = id;
+  }
+}
+
+int ConditionTable::intern(vector<Fact> &facts) {
+  sort(facts.begin(), facts.end());
+  size_t hash = hash_facts(facts);
+  ConditionTableLock lock(mutex);
+  size_t mask = buckets.size() - 1;
+  size_t bucket = hash & mask;
+  while(buckets[bucket] != -1) {
+    const Entry &entry = entries[buckets[bucket]];
+    if(entry.hash == hash && entry.facts.size() == facts.size() &&
+       equal(facts.begin(), facts.end(), entry.facts.begin()))
+      return buckets[bucket];
+    bucket = (bucket + 1) & mask;
+  }
+  Entry entry;
+  entry.facts = arena.copy(facts);
+  entry.hash = hash;
+  int id = entries.size();
+  entries.push_back(entry);
+  buckets[bucket] = id;
+  total_facts += facts.size();
+  if(entries.size() * 2 > buckets.size())
+    grow_buckets();
+  return id;
+}
+
+Span<ConditionTable::Fact> ConditionTable::get(int id) const {
+  ConditionTableLock lock(mutex);
+  return entries[id].facts;
+}
+
+int ConditionTable::size() const {
+  ConditionTableLock lock(mutex);
+  return entries.size();
+}
+
+size_t ConditionTable::get_total_facts() const {
+  ConditionTableLock lock(mutex);
+  return total_facts;
+}
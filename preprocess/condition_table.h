@@ -0,0 +1,76 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+#ifndef CONDITION_TABLE_H
+#define CONDITION_TABLE_H
+
+/*
+  Table of interned condition sets; each PipelineContext has one.
+
+  A condition set is a list of (variable index, value) pairs sorted by
+  variable. The preconditions of operators and the conditions of DTG
+  transitions are interned here and referred to by id, so every
+  distinct set is stored and sorted once, and two sets are equal iff
+  their ids are. Id 0 is always the empty set.
+
+  The sets are stored in the given arena and never move. All methods
+  lock, so the table can be used from the parser threads.
+*/
+
+#include "span.h"
+
+#include <pthread.h>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+using namespace std;
+
+class Arena;
+
+class ConditionTable {
+public:
+  typedef pair<int, int> Fact; // (variable index, value)
+private:
+  struct Entry {
+    Span<Fact> facts;
+    size_t hash;
+  };
+  Arena &arena;
+  vector<Entry> entries;   // indexed by id
+  vector<int> buckets;     // open addressing; -1 is empty
+  size_t total_facts;
+  mutable pthread_mutex_t mutex;
+
+  void grow_buckets();
+
+  ConditionTable(const ConditionTable &copy);
+  ConditionTable &operator=(const ConditionTable &copy);
+public:
+  explicit ConditionTable(Arena &arena);
+  ~ConditionTable();
+
+  // Sorts the facts and returns the id of the set.
+  int intern(vector<Fact> &facts);
+  Span<Fact> get(int id) const;
+  int size() const;
+  size_t get_total_facts() const;
+};
+
+#endif
@@ -32,150 +32,218 @@
 #include "domain_transition_graph.h"
 #include "operator.h"
 #include "axiom.h"
+#include "pipeline_context.h"
 #include "variable.h"
-#include "scc.h"
 
 #include <algorithm>
 #include <cassert>
 #include <iostream>
 using namespace std;
 
-DomainTransitionGraph::DomainTransitionGraph(const Variable &var) {
-  vertices.resize(var.get_range());
-  level = var.get_level();
+DomainTransitionGraph::DomainTransitionGraph(PipelineContext &the_context,
+					     const Variable &var,
+					     const vector<Variable *> &the_variables)
+  : context(&the_context), variables(&the_variables),
+    last_condition_owner(-1), last_condition_id(0) {
+  range = var.get_range();
+  level = context->get_level(&var);
   assert(level != -1);
 }
 
+bool DomainTransitionGraph::start_conditions(int owner) {
+  // The conditions only depend on the operator or axiom and on this
+  // DTG, so consecutive transitions of the same one share them.
+  if(owner == last_condition_owner)
+    return false;
+  last_condition_owner = owner;
+  condition_buffer.clear();
+  return true;
+}
+
+void DomainTransitionGraph::finish_conditions() {
+  // sorts conditions (acc. to variable index)
+  last_condition_id = context->get_conditions().intern(condition_buffer);
+}
+
 void DomainTransitionGraph::addTransition(int from, int to, const Operator &op,
 					  int op_index) {
-  Transition trans(to, op_index);
-  Condition &cond = trans.condition;
-  const vector<Operator::Prevail> &prevail = op.get_prevail();
-  const vector<Operator::PrePost> &pre_post = op.get_pre_post();
-  for(int i = 0; i < prevail.size(); i++)
-    if(true) // [cycles]
-    // if(prevail[i].var->get_level() < level) // [no cycles]
-      // The first condition is the var and the prev state
-      cond.push_back(make_pair(prevail[i].var, prevail[i].prev));
-  for(int i = 0; i < pre_post.size(); i++)
-    if(pre_post[i].var->get_level() != level && pre_post[i].pre != -1 &&
-    		((pre_post[i].pre != -2) && (pre_post[i].pre != -3) && (pre_post[i].pre != -4) && (pre_post[i].pre != -5) && (pre_post[i].pre != -6))) // [cycles]
-    // if(pre_post[i].var->get_level() < level && pre_post[i].pre != -1) //[no cycles]
-      // The other conditions are other prev states in the operator
-      cond.push_back(make_pair(pre_post[i].var, pre_post[i].pre));
-    else
-      if(pre_post[i].var->get_level() == level && pre_post[i].is_conditional_effect)
-	for(int j = 0; j < pre_post[i].effect_conds.size(); j++)
-	  cond.push_back(make_pair(pre_post[i].effect_conds[j].var,
-				   pre_post[i].effect_conds[j].cond));
-
+  if(start_conditions(2 * op_index)) {
+    Span<Operator::Prevail> prevail = op.get_prevail();
+    Span<Operator::PrePost> pre_post = op.get_pre_post();
+    for(int i = 0; i < prevail.size(); i++)
+      if(true) // [cycles]
+      // if(prevail[i].var->get_level() < level) // [no cycles]
+	// The first condition is the var and the prev state
+	condition_buffer.push_back(make_pair(prevail[i].var->get_index(), prevail[i].prev));
+    for(int i = 0; i < pre_post.size(); i++)
+      if(context->get_level(pre_post[i].var) != level && pre_post[i].pre != -1 &&
+	 ((pre_post[i].pre != -2) && (pre_post[i].pre != -3) && (pre_post[i].pre != -4) && (pre_post[i].pre != -5) && (pre_post[i].pre != -6))) // [cycles]
+      // if(pre_post[i].var->get_level() < level && pre_post[i].pre != -1) //[no cycles]
+	// The other conditions are other prev states in the operator
+	condition_buffer.push_back(make_pair(pre_post[i].var->get_index(), pre_post[i].pre));
+      else
+	if(context->get_level(pre_post[i].var) == level && pre_post[i].is_conditional_effect) {
+	  Span<Operator::EffCond> effect_conds = op.get_effect_conds(pre_post[i]);
+	  for(int j = 0; j < effect_conds.size(); j++)
+	    condition_buffer.push_back(make_pair(effect_conds[j].var->get_index(),
+						 effect_conds[j].cond));
+	}
+    finish_conditions();
+  }
   // The transitioin is added to the vertice "from" in this transition graph
-  vertices[from].push_back(trans);
+  add(from, to, op_index);
 }
 void DomainTransitionGraph::addAxTransition(int from, int to, const Axiom &ax,
 					    int ax_index) {
-  Transition trans(to, ax_index);
-  Condition &cond = trans.condition;
-  const vector<Axiom::Condition> &ax_conds = ax.get_conditions();
-  for(int i = 0; i < ax_conds.size(); i++)
-    if(true) // [cycles]
-    // if(prevail[i].var->get_level() < level) // [no cycles]
-      cond.push_back(make_pair(ax_conds[i].var, ax_conds[i].cond));
-  vertices[from].push_back(trans);
+  if(start_conditions(2 * ax_index + 1)) {
+    Span<Axiom::Condition> ax_conds = ax.get_conditions();
+    for(int i = 0; i < ax_conds.size(); i++)
+      if(true) // [cycles]
+      // if(prevail[i].var->get_level() < level) // [no cycles]
+	condition_buffer.push_back(make_pair(ax_conds[i].var->get_index(), ax_conds[i].cond));
+    finish_conditions();
+  }
+  add(from, to, ax_index);
 }
 
-bool DomainTransitionGraph::Transition::operator<(const Transition &other) const {
-  if (target != other.target)
-    return target < other.target;
-  else
-    return condition.size() < other.condition.size();
+void DomainTransitionGraph::add(int from, int to, int op_index) {
+  Span<ConditionTable::Fact> conditions =
+    context->get_conditions().get(last_condition_id);
+  transitions.push_back(Transition(to, op_index, last_condition_id,
+				   conditions));
+  sources.push_back(from);
 }
 
+// Sort transitions according to targets and condition length.
+struct DomainTransitionGraph::TransitionLess {
+  bool operator()(const Transition &trans, const Transition &other) const {
+    if (trans.target != other.target)
+      return trans.target < other.target;
+    else
+      return trans.conditions.size() < other.conditions.size();
+  }
+};
+
 void DomainTransitionGraph::finalize() {
-  for(int i = 0; i < vertices.size(); i++) {
-    // For all sources, sort transitions according to targets and condition length
-    sort(vertices[i].begin(), vertices[i].end());
-    vertices[i].erase(unique(vertices[i].begin(), vertices[i].end()),
-		      vertices[i].end());
-    // For all transitions, sort conditions (acc. to pointer addresses)
-    for(int j = 0; j < vertices[i].size(); j++) {  
-      Transition &trans = vertices[i][j];
-      Condition &cond = trans.condition;
-      sort(cond.begin(), cond.end());
+  // Group the transitions by source value, keeping the order in which
+  // they were added (a stable counting sort). Group range holds the
+  // any-value transitions that are not expanded.
+  bool expand_any_value = !context->get_any_value_transitions();
+  offsets.assign(range + 2, 0);
+  for(int i = 0; i < sources.size(); i++) {
+    if(sources[i] != ANY_VALUE) {
+      offsets[sources[i] + 1]++;
+    } else if(expand_any_value) {
+      for(int value = 0; value < range; value++)
+	if(value != transitions[i].target)
+	  offsets[value + 1]++;
+    } else {
+      offsets[range + 1]++;
     }
-    // Look for dominated transitions
-    vector<Transition> undominated_trans;
-    vector<bool> is_dominated;
-    is_dominated.resize(vertices[i].size(), false);
-    for(int j = 0; j < vertices[i].size(); j++) {
-      if(!is_dominated[j]) {
-	Transition &trans = vertices[i][j];
-	undominated_trans.push_back(trans);
-	Condition &cond = trans.condition;
-	int comp = j + 1; // compare transition no. j to no. comp
-	// comp is dominated if it has same target and same and more conditions
-	while(comp < vertices[i].size()) {
-	  if(is_dominated[comp]) {
-	    comp++;
-	    continue;
-	  }
-	  Transition &other_trans = vertices[i][comp];
-	  assert(other_trans.target >= trans.target);
-	  if(other_trans.target != trans.target)
-	    break; // transition and all after it have different targets
-	  else { //domination possible
-	    assert(other_trans.condition.size() >= cond.size());
-	    if(cond.size() == 0) {
-	      is_dominated[comp] = true; // comp is dominated
-	      comp++;
-	    }	      
-	    else {
-	      bool same_conditions = true;
-	      for(int k = 0; k < cond.size(); k++) {
-		bool cond_k = false;
-		for(int l = 0; l < other_trans.condition.size(); l++) {
-		  if(other_trans.condition[l].first > cond[k].first){
-		    break; // comp doesn't have this condition, not dominated
-		  }
-		  if(other_trans.condition[l].first == cond[k].first &&
-		     other_trans.condition[l].second == cond[k].second) {
-		    cond_k = true;
-		    break; // comp has this condition, look for next cond
-		  }
-		}
-		if(!cond_k) { // comp is not dominated
-		  same_conditions = false; 
-		  break;
-		}
-	      }
-	      is_dominated[comp] = same_conditions;
-	      comp++;
-	    }
-	  }
-	}
+  }
+  for(int i = 0; i <= range; i++)
+    offsets[i + 1] += offsets[i];
+  vector<Transition> grouped;
+  {
+    vector<int> next(offsets.begin(), offsets.end() - 1);
+    grouped.resize(offsets[range + 1],
+		   Transition(0, 0, 0, Span<ConditionTable::Fact>()));
+    for(int i = 0; i < transitions.size(); i++) {
+      if(sources[i] != ANY_VALUE) {
+	grouped[next[sources[i]]++] = transitions[i];
+      } else if(expand_any_value) {
+	for(int value = 0; value < range; value++)
+	  if(value != transitions[i].target)
+	    grouped[next[value]++] = transitions[i];
+      } else {
+	grouped[next[range]++] = transitions[i];
       }
     }
   }
+  vector<int>().swap(sources);
+  vector<ConditionTable::Fact>().swap(condition_buffer);
+
+  // Sort and deduplicate each group; the groups move down as
+  // duplicates are removed.
+  int new_size = 0;
+  vector<int> slots;
+  for(int i = 0; i <= range; i++) {
+    vector<Transition>::iterator begin = grouped.begin() + offsets[i];
+    vector<Transition>::iterator end = grouped.begin() + offsets[i + 1];
+    sort(begin, end, TransitionLess());
+    end = begin + remove_duplicates(&*begin, end - begin, slots);
+    offsets[i] = new_size;
+    new_size = copy(begin, end, grouped.begin() + new_size) - grouped.begin();
+  }
+  offsets[range + 1] = new_size;
+  grouped.erase(grouped.begin() + new_size, grouped.end());
+  transitions.swap(grouped);
 }
 
-void build_DTGs(const vector<Variable *> &var_order,
-		const vector<Operator> &operators,
+static size_t hash_transition(int target, int op, int condition_id) {
+  size_t hash = 2166136261u;
+  hash = (hash ^ target) * 16777619u;
+  hash = (hash ^ op) * 16777619u;
+  hash = (hash ^ condition_id) * 16777619u;
+  return hash;
+}
+
+int DomainTransitionGraph::remove_duplicates(Transition *group, int count,
+					     vector<int> &slots) {
+  // Keeps the first of all transitions with the same target, operator
+  // and conditions, wherever they are in the group. slots is an open
+  // addressing table of kept positions.
+  if(count < 2)
+    return count;
+  size_t size = 4;
+  while(size < 2 * count)
+    size *= 2;
+  slots.assign(size, -1);
+  int kept = 0;
+  for(int i = 0; i < count; i++) {
+    const Transition &trans = group[i];
+    size_t slot = hash_transition(trans.target, trans.op,
+				  trans.condition_id) & (size - 1);
+    bool duplicate = false;
+    while(slots[slot] != -1) {
+      const Transition &other = group[slots[slot]];
+      if(other.target == trans.target && other.op == trans.op &&
+	 other.condition_id == trans.condition_id) {
+	duplicate = true;
+	break;
+      }
+      slot = (slot + 1) & (size - 1);
+    }
+    if(!duplicate) {
+      group[kept] = trans;
+      slots[slot] = kept++;
+    }
+  }
+  return kept;
+}
+
+void build_DTGs(PipelineContext &context,
+		const vector<Variable *> &var_order,
+		const vector<Variable *> &variables,
+		const OperatorTable &operators,
 		const vector<Axiom> &axioms,
 		vector<DomainTransitionGraph> &transition_graphs) {
   // For each var a transition graph is created
+  transition_graphs.reserve(var_order.size());
   for(int i = 0; i < var_order.size(); i++) {
-    transition_graphs.push_back(DomainTransitionGraph(*var_order[i]));
+    transition_graphs.push_back(DomainTransitionGraph(context, *var_order[i],
+						      variables));
   }
 
   // For each operator
   for(int i = 0; i < operators.size(); i++) {
-    const Operator &op = operators[i];
+    Operator op = operators[i];
     // For each effect
-    const vector<Operator::PrePost> &pre_post = op.get_pre_post();
+    Span<Operator::PrePost> pre_post = op.get_pre_post();
     for(int j = 0; j < pre_post.size(); j++) {
     	//If the varable has been explored
       const Variable *var = pre_post[j].var;
-      int var_level = var->get_level();
+      int var_level = context.get_level(var);
       if((var_level != -1) && (pre_post[j].pre != -2 and
     		  pre_post[j].pre != -3 and pre_post[j].pre != -4 and pre_post[j].pre != -5 and pre_post[j].pre != -6)) {
     // Get pre and post
@@ -183,13 +251,11 @@ void build_DTGs(const vector<Variable *> &var_order,
 	int post = pre_post[j].post;
 	// If pre is not a non state
 	// Transition graphs are indexed by variable but ordered by importance
-	if(pre != -1) {
+	if(pre != -1)
 	  transition_graphs[var_level].addTransition(pre, post, op, i);
-	} else {
-	  for(int pre = 0; pre < var->get_range(); pre++)
-	    if(pre != post)
-	      transition_graphs[var_level].addTransition(pre, post, op, i);
-	}
+	else
+	  transition_graphs[var_level].addTransition(
+	    DomainTransitionGraph::ANY_VALUE, post, op, i);
       }
       //else
 	 //cout <<"leave out var "<< var->get_name()<<" (unimportant) " << endl;
@@ -198,7 +264,7 @@ void build_DTGs(const vector<Variable *> &var_order,
   for(int i = 0; i < axioms.size(); i++) {
     const Axiom &ax = axioms[i];
     Variable *var = ax.get_effect_var();
-    int var_level = var->get_level();
+    int var_level = context.get_level(var);
     assert(var_level != -1);
     int old_val = ax.get_old_val();
     int new_val = ax.get_effect_val();
@@ -210,31 +276,42 @@ void build_DTGs(const vector<Variable *> &var_order,
 }
 bool are_DTGs_strongly_connected(const vector<DomainTransitionGraph> &transition_graphs) {
   bool connected = true;
+  DTGConnectivityCheck check;
   // no need to test last variable's dtg (highest level variable)
   for(int i = 0; i < transition_graphs.size() - 1; i++)
-    if(!transition_graphs[i].is_strongly_connected())
+    if(!transition_graphs[i].is_strongly_connected(check))
       connected = false;
   return connected;
 }
-bool DomainTransitionGraph::is_strongly_connected() const {
-  vector<vector<int> > easy_graph;
-  for(int i = 0; i < vertices.size(); i++) {
-    vector<int> empty_vector;
-    easy_graph.push_back(empty_vector);
-    for(int j = 0; j < vertices[i].size(); j++) {
-      const Transition &trans = vertices[i][j];
-      easy_graph[i].push_back(trans.target);
-    }
+bool DomainTransitionGraph::is_strongly_connected(DTGConnectivityCheck &check) const {
+  if(CompactGraph<unsigned short>::fits(range))
+    return is_strongly_connected(check.small_graph, check.small_scc, check);
+  else
+    return is_strongly_connected(check.graph, check.scc, check);
+}
+template<class Index>
+bool DomainTransitionGraph::is_strongly_connected(CompactGraph<Index> &graph,
+						  SCC<Index> &scc,
+						  DTGConnectivityCheck &check) const {
+  graph.clear();
+  for(int i = 0; i < range; i++) {
+    for(int j = offsets[i]; j < offsets[i + 1]; j++)
+      graph.add_arc(transitions[j].target);
+    for(int j = offsets[range]; j < offsets[range + 1]; j++)
+      if(transitions[j].target != i)
+	graph.add_arc(transitions[j].target);
+    graph.finish_node();
   }
-  vector<vector<int> > sccs = SCC(easy_graph).get_result();
+  scc.get_result(graph, check.components, check.component_offsets);
+  int scc_count = check.component_offsets.size() - 1;
  //  cout << "easy graph sccs for var " << level << endl;
-//   for(int i = 0; i < sccs.size(); i++) {
-//     for(int j = 0; j < sccs[i].size(); j++)
-//       cout << " " << sccs[i][j];
+//   for(int i = 0; i < scc_count; i++) {
+//     for(int j = check.component_offsets[i]; j < check.component_offsets[i + 1]; j++)
+//       cout << " " << check.components[j];
 //     cout << endl;
 //   }
   bool connected = false;
-  if(sccs.size() == 1){
+  if(scc_count == 1){
     connected = true;
     //cout <<"is strongly connected" << endl;
   }
@@ -243,37 +320,51 @@ bool DomainTransitionGraph::is_strongly_connected() const {
 }
 void DomainTransitionGraph::dump() const {
   cout << "Level: " << level << endl;
-  for(int i = 0; i < vertices.size(); i++) {
-    cout << "  From value " << i << ":" << endl;
-    for(int j = 0; j < vertices[i].size(); j++) {
-      const Transition &trans = vertices[i][j];
+  for(int i = 0; i <= range; i++) {
+    if(i < range)
+      cout << "  From value " << i << ":" << endl;
+    else if(offsets[range] != offsets[range + 1])
+      cout << "  From any other value:" << endl;
+    for(int j = offsets[i]; j < offsets[i + 1]; j++) {
+      const Transition &trans = transitions[j];
       cout << "    " << "To value " << trans.target << endl;
-      for(int k = 0; k < trans.condition.size(); k++)
-	cout << "      if " << trans.condition[k].first->get_name()
-	     << " = " << trans.condition[k].second << endl;
+      for(int k = 0; k < trans.conditions.size(); k++)
+	cout << "      if " << (*variables)[trans.conditions[k].first]->get_name()
+	     << " = " << trans.conditions[k].second << endl;
     }
   }
 }
 
-void DomainTransitionGraph::generate_cpp_input(ofstream &outfile) const {
-  //outfile << vertices.size() << endl; // the variable's range
-  for(int i = 0; i < vertices.size(); i++) {
-    outfile << vertices[i].size() << endl; // number of transitions from this value
-    for(int j = 0; j < vertices[i].size(); j++) {
-      const Transition &trans = vertices[i][j];
-      outfile << trans.target << endl;  // target of transition
-      outfile << trans.op << endl; // operator doing the transition
-      // calculate number of important prevail conditions
-      int number = 0;
-      for(int k = 0; k < trans.condition.size(); k++)
-	if(trans.condition[k].first->get_level() != -1)
-	  number++;
-      outfile << number << endl; 
-      for(int k = 0; k < trans.condition.size(); k++)
-	if(trans.condition[k].first->get_level() != -1)
-	  outfile << trans.condition[k].first->get_level() <<
-	    " " << trans.condition[k].second << endl; // condition: var, val
-    }
+void DomainTransitionGraph::write_transition(ofstream &outfile,
+					     const Transition &trans) const {
+  outfile << trans.target << endl;  // target of transition
+  outfile << trans.op << endl; // operator doing the transition
+  // calculate number of important prevail conditions
+  Span<ConditionTable::Fact> conditions = trans.conditions;
+  int number = 0;
+  for(int k = 0; k < conditions.size(); k++)
+    if(context->get_level((*variables)[conditions[k].first]) != -1)
+      number++;
+  outfile << number << endl; 
+  for(int k = 0; k < conditions.size(); k++) {
+    int cond_level = context->get_level((*variables)[conditions[k].first]);
+    if(cond_level != -1)
+      outfile << cond_level <<
+	" " << conditions[k].second << endl; // condition: var, val
   }
 }
 
+void DomainTransitionGraph::generate_cpp_input(ofstream &outfile) const {
+  //outfile << range << endl; // the variable's range
+  for(int i = 0; i < range; i++) {
+    outfile << offsets[i + 1] - offsets[i] << endl; // number of transitions from this value
+    for(int j = offsets[i]; j < offsets[i + 1]; j++)
+      write_transition(outfile, transitions[j]);
+  }
+  if(context->get_any_value_transitions()) {
+    // transitions from every value other than their target
+    outfile << offsets[range + 1] - offsets[range] << endl;
+    for(int j = offsets[range]; j < offsets[range + 1]; j++)
+      write_transition(outfile, transitions[j]);
+  }
+}
@@ -23,43 +23,102 @@
 #ifndef DOMAIN_TRANSITION_GRAPH_H
 #define DOMAIN_TRANSITION_GRAPH_H
 
+#include "compact_graph.h"
+#include "condition_table.h"
+#include "scc.h"
+#include "span.h"
+
 #include <vector>
 #include <fstream>
 using namespace std;
 
 class Operator;
+class OperatorTable;
+class PipelineContext;
 class Axiom;
 class Variable;
 
+/*
+  The transitions of a DTG are kept in flat arrays. After finalize(),
+  the transitions leaving value v are transitions[offsets[v]] ..
+  transitions[offsets[v + 1] - 1]. Their conditions are sets in the
+  context's ConditionTable. All transitions that an operator or axiom
+  induces in one DTG have the same conditions.
+
+  An effect without a precondition is added as a single transition
+  from ANY_VALUE, meaning every value other than its target. finalize()
+  expands these into one transition per source value, unless the
+  context asks for any-value transitions; then they are kept in an
+  extra group, offsets[range] .. offsets[range + 1] - 1, and written
+  in a list of their own.
+*/
+
+// Working memory for DomainTransitionGraph::is_strongly_connected(),
+// reused from one DTG to the next. Almost all domains fit the 16 bit
+// graph.
+struct DTGConnectivityCheck {
+  CompactGraph<unsigned short> small_graph;
+  SCC<unsigned short> small_scc;
+  CompactGraph<unsigned int> graph;
+  SCC<unsigned int> scc;
+  vector<int> components;
+  vector<int> component_offsets;
+};
+
 class DomainTransitionGraph {
-public:
-  typedef vector<pair<const Variable *, int> > Condition;
-private:
   struct Transition {
-    Transition(int theTarget, int theOp) : target(theTarget), op(theOp) {}
-    bool operator==(const Transition &other) const {return target == other.target &&
-						      op == other.op &&
-						      condition == other.condition;}
-    bool operator<(const Transition &other) const;
+    Transition(int theTarget, int theOp, int theConditionId,
+	       Span<ConditionTable::Fact> theConditions)
+      : target(theTarget), op(theOp), condition_id(theConditionId),
+	conditions(theConditions) {}
     int target;
     int op;
-    Condition condition;
+    int condition_id;
+    Span<ConditionTable::Fact> conditions;
   };
-  typedef vector<Transition> Vertex;
-  vector<Vertex> vertices;
+  struct TransitionLess;
+
+  PipelineContext *context;
+  const vector<Variable *> *variables; // by index
   int level;
+  int range;
+  vector<Transition> transitions;
+  vector<int> offsets;
+
+  // Before finalize(): source value (or ANY_VALUE) of each
+  // transition, and the operator (2 * index) or axiom (2 * index + 1)
+  // whose conditions were interned last, with their id.
+  vector<int> sources;
+  int last_condition_owner;
+  int last_condition_id;
+  vector<ConditionTable::Fact> condition_buffer;
+
+  bool start_conditions(int owner);
+  void finish_conditions();
+  void add(int from, int to, int op_index);
+  void write_transition(ofstream &outfile, const Transition &trans) const;
+  static int remove_duplicates(Transition *group, int count,
+			       vector<int> &slots);
+  template<class Index>
+  bool is_strongly_connected(CompactGraph<Index> &graph, SCC<Index> &scc,
+			     DTGConnectivityCheck &check) const;
 public:
-  DomainTransitionGraph(const Variable &var);
+  static const int ANY_VALUE = -1;
+
+  DomainTransitionGraph(PipelineContext &context, const Variable &var,
+			const vector<Variable *> &variables);
   void addTransition(int from, int to, const Operator &op, int op_index);
   void addAxTransition(int from, int to, const Axiom &ax, int ax_index);
   void finalize();
   void dump() const;
   void generate_cpp_input(ofstream &outfile) const;
-  bool is_strongly_connected() const;
+  bool is_strongly_connected(DTGConnectivityCheck &check) const;
 };
 
-extern void build_DTGs(const vector<Variable *> &varOrder,
-		       const vector<Operator> &operators,
+extern void build_DTGs(PipelineContext &context,
+		       const vector<Variable *> &varOrder,
+		       const vector<Variable *> &variables,
+		       const OperatorTable &operators,
 		       const vector<Axiom> &axioms,
 		       vector<DomainTransitionGraph> &transition_graphs);
 extern bool are_DTGs_strongly_connected(const vector<DomainTransitionGraph> &transition_graphs); 
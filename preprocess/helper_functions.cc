@@ -24,6 +24,9 @@
 #include <iostream>
 #include <fstream>
 
+#include <pthread.h>
+#include <unistd.h>
+
 #include <string>
 #include <vector>
 using namespace std;
@@ -35,73 +38,64 @@ using namespace std;
 #include "variable.h"
 #include "successor_generator.h"
 #include "domain_transition_graph.h"
+#include "tokenizer.h"
+#include "string_table.h"
 
-void check_magic(istream &in, string magic) {
-  string word;
-  in >> word;
-  if(word != magic) {
-    cout << "Failed to match magic word '" << magic << "'." << endl;
-    cout << "Got '" << word << "'." << endl;
-    exit(1);
-  }
-}
+void read_metric(Tokenizer &in, string& metric) {
 
-void read_metric(istream &in, string& metric) {
-
-  string aux = "";
+  const char *aux;
+  size_t aux_length;
 
   metric = "";
-  check_magic(in, "begin_metric");
-  in >> aux;
-  while(aux != "end")
+  in.check_magic("begin_metric");
+  in.read_token(aux, aux_length);
+  while(!in.token_equals(aux, aux_length, "end"))
   {
-	  metric = metric + "-" + aux;
-	  in >> aux;
+	  metric.append("-").append(aux, aux_length);
+	  in.read_token(aux, aux_length);
   }
 
-  check_magic(in, "end_metric");
+  in.check_magic("end_metric");
 }
 
-void read_variables(istream &in, vector<Variable> &internal_variables,
+void read_variables(Tokenizer &in, StringTable &strings,
+		    vector<Variable> &internal_variables,
 		    vector<Variable *> &variables) {
-  check_magic(in, "begin_variables");
-  int count;
-  in >> count;
+  in.check_magic("begin_variables");
+  int count = in.read_int();
   internal_variables.reserve(count);
   // Important so that the iterators stored in variables are valid.
   for(int i = 0; i < count; i++) {
-    internal_variables.push_back(Variable(in));
+    internal_variables.push_back(Variable(in, strings, i));
     variables.push_back(&internal_variables.back());
   }
-  check_magic(in, "end_variables");
+  in.check_magic("end_variables");
 }
 
-void read_shared(istream &in, vector<Variable *> &shared_vars, vector<int> &shared_vars_number,
+void read_shared(Tokenizer &in, vector<Variable *> &shared_vars, vector<int> &shared_vars_number,
 		const vector<Variable *> &variables) {
-  check_magic(in, "begin_shared");
-  int count;
-  in >> count;
+  in.check_magic("begin_shared");
+  int count = in.read_int();
   shared_vars.reserve(count);
   for(int i = 0; i < count; i++) {
-	  int var, var2;
-	  in >> var >> var2;
+	  in.read_int(); // index in the translator's numbering, unused
+	  int var2 = in.read_int();
 	  shared_vars.push_back(variables[var2]);
 	  shared_vars_number.push_back(var2);
   }
-  check_magic(in, "end_shared");
+  in.check_magic("end_shared");
 }
 
-void read_goal(istream &in, const vector<Variable *> &variables,  
+void read_goal(Tokenizer &in, const vector<Variable *> &variables,  
 	       vector<pair<Variable*, int> > &goals) { 
-  check_magic(in, "begin_goal");
-  int count;
-  in >> count;
+  in.check_magic("begin_goal");
+  int count = in.read_int();
   for(int i = 0; i < count; i++) {
-    int varNo, val;
-    in >> varNo >> val;
+    int varNo = in.read_int();
+    int val = in.read_int();
     goals.push_back(make_pair(variables[varNo], val));
   }
-  check_magic(in, "end_goal");
+  in.check_magic("end_goal");
 }
 
 void dump_goal(const vector<pair<Variable*, int> > &goals) {
@@ -111,45 +105,158 @@ void dump_goal(const vector<pair<Variable*, int> > &goals) {
 	 << goals[i].second << endl;
 }
 
-void read_operators(istream &in, const vector<Variable *> &variables, 
-		    vector<Operator> &operators) {
-  int count;
-  in >> count;
-  for(int i = 0; i < count; i++)
-    operators.push_back(Operator(in, variables));
+static int get_parse_thread_count(const PipelineContext &context) {
+  if(context.get_parse_threads() > 0)
+    return context.get_parse_threads();
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+  return cores > 0 ? cores : 1;
+}
+
+/* Parallel parsing of the operator and axiom sections.
+ * The section is first split into the text ranges of its entries by
+ * looking for the begin and end magic words only. Each thread then
+ * parses a contiguous run of entries with its own tokenizer, and the
+ * per-thread results are concatenated in thread order, so the entries
+ * end up in the same order as with serial parsing.
+ */
+typedef vector<pair<const char *, const char *> > TextRanges;
+
+// Reading and concatenating entries, for each kind of entry container.
+static void read_entry(PipelineContext &, Tokenizer &in,
+		       const vector<Variable *> &variables,
+		       OperatorTable &operators) {
+  operators.read(in, variables);
+}
+
+static void read_entry(PipelineContext &context, Tokenizer &in,
+		       const vector<Variable *> &variables,
+		       vector<Axiom> &axioms) {
+  axioms.push_back(Axiom(in, variables, context.get_task_arena()));
+}
+
+static void append_entries(OperatorTable &operators,
+			   const OperatorTable &more) {
+  operators.append(more);
+}
+
+static void append_entries(vector<Axiom> &axioms, const vector<Axiom> &more) {
+  axioms.insert(axioms.end(), more.begin(), more.end());
 }
-void read_axioms(istream &in, const vector<Variable *> &variables, 
-		    vector<Axiom> &axioms) {
-  int count;
-  in >> count;
-  for(int i = 0; i < count; i++)
-    axioms.push_back(Axiom(in, variables));
+
+template<class Entries>
+struct ParseJob {
+  PipelineContext *context;
+  const TextRanges *ranges;
+  int first, last;
+  const vector<Variable *> *variables;
+  Entries entries;
+  // empty is a container without entries, copied so that the jobs'
+  // entries use the same tables as the result.
+  explicit ParseJob(const Entries &empty) : entries(empty) {}
+};
+
+template<class Entries>
+void *parse_entries(void *arg) {
+  ParseJob<Entries> &job = *static_cast<ParseJob<Entries> *>(arg);
+  job.entries.reserve(job.last - job.first);
+  for(int i = job.first; i < job.last; i++) {
+    Tokenizer in((*job.ranges)[i].first, (*job.ranges)[i].second);
+    read_entry(*job.context, in, *job.variables, job.entries);
+  }
+  return 0;
 }
 
+template<class Entries>
+void read_entries(PipelineContext &context, Tokenizer &in,
+		  const vector<Variable *> &variables,
+		  const char *begin_magic, const char *end_magic,
+		  Entries &entries) {
+  int count = in.read_int();
+  int thread_count = get_parse_thread_count(context);
+  if(thread_count > count)
+    thread_count = count;
+  if(thread_count <= 1) {
+    entries.reserve(count);
+    for(int i = 0; i < count; i++)
+      read_entry(context, in, variables, entries);
+    return;
+  }
+
+  // The ranges point into the input buffer, which must not move.
+  in.load_remaining();
+  TextRanges ranges;
+  ranges.reserve(count);
+  for(int i = 0; i < count; i++) {
+    const char *start = in.position();
+    in.check_magic(begin_magic);
+    // The rest of this line may be an operator name, which must not
+    // be searched for the end magic word.
+    in.skip_line();
+    in.skip_past(end_magic);
+    ranges.push_back(make_pair(start, in.position()));
+  }
 
-void read_preprocessed_problem_description(istream &in,
+  vector<ParseJob<Entries> > jobs(thread_count, ParseJob<Entries>(entries));
+  vector<pthread_t> threads(thread_count);
+  entries.reserve(count);
+  for(int t = 0; t < thread_count; t++) {
+    jobs[t].context = &context;
+    jobs[t].ranges = &ranges;
+    jobs[t].first = (long) count * t / thread_count;
+    jobs[t].last = (long) count * (t + 1) / thread_count;
+    jobs[t].variables = &variables;
+  }
+  // The calling thread takes the first job itself.
+  for(int t = 1; t < thread_count; t++) {
+    if(pthread_create(&threads[t], 0, parse_entries<Entries>, &jobs[t]) != 0) {
+      cout << "Could not start parser thread." << endl;
+      exit(1);
+    }
+  }
+  parse_entries<Entries>(&jobs[0]);
+  for(int t = 1; t < thread_count; t++)
+    pthread_join(threads[t], 0);
+  for(int t = 0; t < thread_count; t++)
+    append_entries(entries, jobs[t].entries);
+}
+
+void read_operators(PipelineContext &context, Tokenizer &in,
+		    const vector<Variable *> &variables,
+		    OperatorTable &operators) {
+  read_entries(context, in, variables, "begin_operator", "end_operator",
+	       operators);
+}
+void read_axioms(PipelineContext &context, Tokenizer &in,
+		 const vector<Variable *> &variables,
+		 vector<Axiom> &axioms) {
+  read_entries(context, in, variables, "begin_rule", "end_rule", axioms);
+}
+
+
+void read_preprocessed_problem_description(PipelineContext &context,
+					   Tokenizer &in,
 		               string &metric,
 					   vector<Variable> &internal_variables, 
 					   vector<Variable *> &variables, 
 					   State &initial_state,
 					   vector<pair<Variable*, int> > &goals,
-					   vector<Operator> &operators,
+					   OperatorTable &operators,
 					   vector<Axiom> &axioms,
 					   vector<Variable *> &shared_vars,
 					   vector<int> &shared_vars_number) {
   read_metric(in, metric); 
-  read_variables(in, internal_variables, variables);
+  read_variables(in, context.get_strings(), internal_variables, variables);
   initial_state = State(in, variables);
   read_shared(in, shared_vars, shared_vars_number, variables);
   read_goal(in, variables, goals);
-  read_operators(in, variables, operators);
-  read_axioms(in, variables, axioms);
+  read_operators(context, in, variables, operators);
+  read_axioms(context, in, variables, axioms);
 }
 
 void dump_preprocessed_problem_description(const vector<Variable *> &variables, 
 					   const State &initial_state,
 					   const vector<pair<Variable*, int> > &goals,
-					   const vector<Operator> &operators,
+					   const OperatorTable &operators,
 					   const vector<Axiom> &axioms) {
 
   cout << "Variables (" << variables.size() << "):" << endl;
@@ -157,7 +264,7 @@ void dump_preprocessed_problem_description(const vector<Variable *> &variables,
     variables[i]->dump();
 
   cout << "Initial State:" << endl;
-  initial_state.dump();
+  initial_state.dump(variables);
   dump_goal(goals);
 
   for(int i = 0; i < operators.size(); i++)
@@ -183,21 +290,34 @@ std::string ReplaceAll(std::string str, const std::string& from, const std::stri
     return str;
 }
 
-void generate_cpp_input(bool solveable_in_poly_time,
+static void generate_operator_names(ofstream &outfile,
+				    const StringTable &strings,
+				    const OperatorTable &operators) {
+  outfile << "begin_operator_names" << endl;
+  outfile << operators.size() << endl;
+  for(int i = 0; i < operators.size(); i++) {
+    strings.write(outfile, operators[i].get_name_id());
+    outfile << endl;
+  }
+  outfile << "end_operator_names" << endl;
+}
+
+void generate_cpp_input(const PipelineContext &context,
+			bool solveable_in_poly_time,
 			const vector<Variable *> & ordered_vars, 
 			const string &metric,
 			const State &initial_state,
 			const vector<pair<Variable*, int> > &goals,
-			const vector<Operator> & operators,
+			const OperatorTable &operators,
 			const vector<Axiom> &axioms,
 			const SuccessorGenerator &sg,
-			const vector<DomainTransitionGraph> transition_graphs,
+			const vector<DomainTransitionGraph> &transition_graphs,
 			const CausalGraph &cg,
-			string name,
-			vector<Variable *> &shared_vars,
-			vector<int> &shared_vars_number,
-			vector<Variable *> variables,
-			string prefix) {
+			const string &name,
+			const vector<Variable *> &shared_vars,
+			const vector<int> &shared_vars_number,
+			const vector<Variable *> &variables,
+			const string &prefix) {
   ofstream outfile;
   string metric_str;
   string f_name = "output_prepro";
@@ -220,14 +340,17 @@ void generate_cpp_input(bool solveable_in_poly_time,
   int var_count = ordered_vars.size();
   outfile << "begin_variables" << endl;
   outfile << var_count << endl;
-  for(int i = 0; i < var_count; i++) 
-    outfile << ordered_vars[i]->get_name()  << " " << 
+  for(int i = 0; i < var_count; i++) {
+    context.get_strings().write(outfile, ordered_vars[i]->get_name_id());
+    outfile << " " << 
       ordered_vars[i]->get_range() << " " << ordered_vars[i]->get_layer() << " " << ordered_vars[i]->get_isTotalTime() << endl;
+  }
   outfile << "end_variables" << endl;
   outfile << "begin_state" << endl;
   for(int i = 0; i < var_count; i++){
-    outfile << initial_state[ordered_vars[i]];// for axioms default value
-  	if (initial_state[ordered_vars[i]] == -1)
+    int value = initial_state[ordered_vars[i]];
+    outfile << value;// for axioms default value
+  	if (value == -1)
   	{
   		outfile << " " << initial_state.get_numeric_value(ordered_vars[i]) << endl;
   	}else
@@ -240,22 +363,24 @@ void generate_cpp_input(bool solveable_in_poly_time,
   int shared_count = shared_vars.size();
   outfile << "begin_shared" << endl;
   outfile << shared_count << endl;
-  vector<string> ordered_shared_values;
-  ordered_shared_values.resize(var_count, "-1");
+  vector<int> ordered_shared_names; // string table ids
+  ordered_shared_names.resize(var_count, -1);
   for(int i = 0; i < shared_vars_number.size(); i++) {
-    int var_index = shared_vars[i]->get_level();
-    ordered_shared_values[var_index] = shared_vars[i]->get_name();
+    int var_index = context.get_level(shared_vars[i]);
+    ordered_shared_names[var_index] = shared_vars[i]->get_name_id();
   }
   for(int i = 0; i < var_count; i++)
-    if(ordered_shared_values[i] != "-1")
-      outfile << ordered_shared_values[i] << " " <<  i  << " " << endl;
+    if(ordered_shared_names[i] != -1) {
+      context.get_strings().write(outfile, ordered_shared_names[i]);
+      outfile << " " <<  i  << " " << endl;
+    }
   outfile << "end_shared" << endl;
 
 
   vector<int> ordered_goal_values;
   ordered_goal_values.resize(var_count, -1);
   for(int i = 0; i < goals.size(); i++) {
-    int var_index = goals[i].first->get_level();
+    int var_index = context.get_level(goals[i].first);
     ordered_goal_values[var_index] = goals[i].second;
   }
   outfile << "begin_goal" << endl;
@@ -267,11 +392,11 @@ void generate_cpp_input(bool solveable_in_poly_time,
 
   outfile << operators.size() << endl;
   for(int i = 0; i < operators.size(); i++)
-    operators[i].generate_cpp_input(outfile, variables);
+    operators[i].generate_cpp_input(outfile, context, variables, i);
 
   outfile << axioms.size() << endl;
   for(int i = 0; i < axioms.size(); i++)
-    axioms[i].generate_cpp_input(outfile);
+    axioms[i].generate_cpp_input(outfile, context);
 
   outfile << "begin_SG" << endl;
   sg.generate_cpp_input(outfile);
@@ -287,6 +412,15 @@ void generate_cpp_input(bool solveable_in_poly_time,
   cg.generate_cpp_input(outfile, ordered_vars);
   outfile << "end_CG" << endl;
 
+  if(context.get_operator_names() == OPERATOR_NAMES_SECTION)
+    generate_operator_names(outfile, context.get_strings(), operators);
   outfile.close();
+
+  if(context.get_operator_names() == OPERATOR_NAMES_SIDECAR) {
+    string names_f_name = f_name + ".names";
+    ofstream names_file(names_f_name.c_str(), ios::out);
+    generate_operator_names(names_file, context.get_strings(), operators);
+    names_file.close();
+  }
 }
 
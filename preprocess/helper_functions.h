@@ -28,6 +28,7 @@
 #include "variable.h"
 #include "successor_generator.h"
 #include "causal_graph.h"
+#include "pipeline_context.h"
 
 #include <string>
 #include <vector>
@@ -36,20 +37,22 @@
 using namespace std;
 
 class State;
-class Operator;
+class OperatorTable;
 class Axiom;
 class DomainTransitionGraph;
+class Tokenizer;
 
 std::string ReplaceAll(std::string str, const std::string& from, const std::string& to);
 
 //void read_everything
-void read_preprocessed_problem_description(istream &in,
+void read_preprocessed_problem_description(PipelineContext &context,
+					   Tokenizer &in,
 					   string &metric,
 					   vector<Variable> &internal_variables, 
 					   vector<Variable *> &variables, 
 					   State &initial_state,
 					   vector<pair<Variable*, int> > &goals,
-					   vector<Operator> &operators,
+					   OperatorTable &operators,
 					   vector<Axiom> &axioms,
 					   vector<Variable *> &shared_vars,
 					   vector<int> &shared_vars_number);
@@ -58,26 +61,26 @@ void read_preprocessed_problem_description(istream &in,
 void dump_preprocessed_problem_description(const vector<Variable *> &variables, 
 					   const State &initial_state,
 					   const vector<pair<Variable*, int> > &goals,
-					   const vector<Operator> &operators,
+					   const OperatorTable &operators,
 					   const vector<Axiom> &axioms); 
 
 void dump_DTGs(const vector<Variable *> &ordering,
 	       vector<DomainTransitionGraph> &transition_graphs );
-void generate_cpp_input(bool causal_graph_acyclic,
+void generate_cpp_input(const PipelineContext &context,
+			bool causal_graph_acyclic,
 			const vector<Variable *> & ordered_var, 
 			const string &metric,
 			const State &initial_state,
 			const vector<pair<Variable*, int> > &goals,
-			const vector<Operator> & operators,
+			const OperatorTable &operators,
 			const vector<Axiom> &axioms,
 			const SuccessorGenerator &sg,
-			const vector<DomainTransitionGraph> transition_graphs,
+			const vector<DomainTransitionGraph> &transition_graphs,
 			const CausalGraph &cg,
-			string name,
-			vector<Variable *> &shared_vars,
-			vector<int> &shared_vars_number,
-			vector<Variable *> variables,
-			string prefix);
-void check_magic(istream &in, string magic);
+			const string &name,
+			const vector<Variable *> &shared_vars,
+			const vector<int> &shared_vars_number,
+			const vector<Variable *> &variables,
+			const string &prefix);
 
 #endif
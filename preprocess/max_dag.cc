@@ -22,61 +22,123 @@
 
 #include "max_dag.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 using namespace std;
 
-vector<int> MaxDAG::get_result() {
+template<class Index>
+bool MaxDAG<Index>::is_less(int node1, int node2) const {
+  if(incoming_weights[node1] != incoming_weights[node2])
+    return incoming_weights[node1] < incoming_weights[node2];
+  return stamps[node1] < stamps[node2];
+}
+
+template<class Index>
+void MaxDAG<Index>::sift_up(int pos) {
+  int node = heap[pos];
+  while(pos > 0) {
+    int parent_pos = (pos - 1) / 4;
+    if(!is_less(node, heap[parent_pos]))
+      break;
+    heap[pos] = heap[parent_pos];
+    heap_positions[heap[pos]] = pos;
+    pos = parent_pos;
+  }
+  heap[pos] = node;
+  heap_positions[node] = pos;
+}
+
+template<class Index>
+void MaxDAG<Index>::sift_down(int pos) {
+  int node = heap[pos];
+  int size = heap.size();
+  while(true) {
+    int first_child = 4 * pos + 1;
+    if(first_child >= size)
+      break;
+    int min_pos = first_child;
+    int last_child = min(first_child + 4, size);
+    for(int child = first_child + 1; child < last_child; child++)
+      if(is_less(heap[child], heap[min_pos]))
+	min_pos = child;
+    if(!is_less(heap[min_pos], node))
+      break;
+    heap[pos] = heap[min_pos];
+    heap_positions[heap[pos]] = pos;
+    pos = min_pos;
+  }
+  heap[pos] = node;
+  heap_positions[node] = pos;
+}
+
+// Gives the node a new weight and moves it behind the nodes of equal
+// weight, as if it had been taken out of the heap and put back in.
+template<class Index>
+void MaxDAG<Index>::set_weight(int node, int weight) {
+  incoming_weights[node] = weight;
+  stamps[node] = current_stamp++;
+  int pos = heap_positions[node];
+  sift_up(pos);
+  if(heap_positions[node] == pos)
+    sift_down(pos);
+}
+
+template<class Index>
+void MaxDAG<Index>::get_result(const CompactGraph<Index> &graph,
+			       vector<int> &result) {
+  int node_count = graph.get_node_count();
   if(debug){
-    for(int i = 0; i < weighted_graph.size(); i++) {
+    for(int i = 0; i < node_count; i++) {
       cout << "From " << i << ":";
-      for(int j = 0; j < weighted_graph[i].size(); j++)
-	cout << " " << weighted_graph[i][j].first
-	   << " [weight " << weighted_graph[i][j].second << "]";
+      for(int j = graph.begin(i); j < graph.end(i); j++)
+	cout << " " << graph.get_target(j)
+	   << " [weight " << graph.get_weight(j) << "]";
       cout << endl;
     }
   }
-  vector<int> incoming_weights; // indexed by the graph's nodes
-  incoming_weights.resize(weighted_graph.size(), 0);
-  for(int node = 0; node < weighted_graph.size(); node++) {
-    const vector<pair<int, int> > &weighted_edges = weighted_graph[node];
-    for(int i = 0; i < weighted_edges.size(); i++)
-      incoming_weights[weighted_edges[i].first] += weighted_edges[i].second;
-  }
+  incoming_weights.assign(node_count, 0);
+  for(int i = 0; i < graph.get_arc_count(); i++)
+    incoming_weights[graph.get_target(i)] += graph.get_weight(i);
   
   // Build minHeap of nodes, compared by number of incoming edges.
-  typedef multimap<int, int>::iterator HeapPosition;
-
-  vector<HeapPosition> heap_positions;
-  multimap<int, int> heap;
-  for(int node = 0; node < weighted_graph.size(); node++) {
+  // The nodes are stamped in order, so equal weights keep node order.
+  stamps.resize(node_count);
+  heap.clear();
+  heap_positions.resize(node_count);
+  for(int node = 0; node < node_count; node++) {
     if(debug)
       cout << "node "<< node << " has "<< incoming_weights[node] << " edges" << endl;
-    HeapPosition pos = heap.insert(make_pair(incoming_weights[node], node));
-    heap_positions.push_back(pos);
+    stamps[node] = node;
+    heap.push_back(node);
+    heap_positions[node] = node;
   }
-  vector<bool> done;
-  done.resize(weighted_graph.size(), false);
+  current_stamp = node_count;
+  for(int pos = (node_count - 2) / 4; pos >= 0; pos--)
+    sift_down(pos);
 
-  vector<int> result;
+  result.clear();
   // Recursively delete node with minimal weight of incoming edges.
   while(!heap.empty()) {
-    if(debug) cout << "minimal element is " << heap.begin()->second << endl;
-    int removed = heap.begin()->second;
-    done[removed] = true;
+    int removed = heap[0];
+    if(debug) cout << "minimal element is " << removed << endl;
+    heap_positions[removed] = -1;
     result.push_back(removed);
-    heap.erase(heap.begin());
-    const vector<pair<int, int> > &succs = weighted_graph[removed];
-    for(int i = 0; i < succs.size(); i++) {
-      int target = succs[i].first;
-      if(!done[target]) {
-	int arc_weight = succs[i].second;
-	while(arc_weight >= 100000)
-	  arc_weight -= 100000;
+    int last = heap.back();
+    heap.pop_back();
+    if(!heap.empty()) {
+      heap[0] = last;
+      sift_down(0);
+    }
+    for(int i = graph.begin(removed); i < graph.end(removed); i++) {
+      int target = graph.get_target(i);
+      if(heap_positions[target] != -1) {
+	// The bonus of arcs into goal variables (a multiple of 100000)
+	// stays in the target's weight.
+	int arc_weight = graph.get_weight(i) % 100000;
 	//cout << "Looking at arc from " << removed << " to " << target << endl;
-	int new_weight = heap_positions[target]->first - arc_weight;
-	heap.erase(heap_positions[target]);
-	heap_positions[target] = heap.insert(make_pair(new_weight, target));
+	int new_weight = incoming_weights[target] - arc_weight;
+	set_weight(target, new_weight);
 	if(debug)
 	  cout << "node " << target << " has now " << new_weight << " edges " << endl;
       }
@@ -88,9 +150,11 @@ vector<int> MaxDAG::get_result() {
 	cout << result[i] <<" - ";
     cout << endl;
   }
-  return result;
 }
 
+template class MaxDAG<unsigned short>;
+template class MaxDAG<unsigned int>;
+
 /*
 #include <iostream>
 using namespace std;
@@ -115,15 +179,15 @@ int main() {
   int n7[] = {2, 5, -1};
   int *all_nodes[] = {n0, n1, n2, n3, n4, n5, n6, n7, 0};
 
-  vector<vector<pair<int, int> > > graph;
+  CompactGraph<unsigned short> graph;
   for(int i = 0; all_nodes[i] != 0; i++) {
-    vector<pair<int, int> > weighted_successors;
     for(int j = 0; all_nodes[i][j] != -1; j++)
-      weighted_successors.push_back(make_pair(all_nodes[i][j],all_nodes[i][j]));
-    graph.push_back(weighted_successors);
+      graph.add_arc(all_nodes[i][j], all_nodes[i][j]);
+    graph.finish_node();
   }
 
-  vector<int> m = MaxDAG(graph).get_result();
+  vector<int> m;
+  MaxDAG<unsigned short>().get_result(graph, m);
   for(int i = 0; i < m.size(); i++) 
     cout << m[i] << " - ";
   cout << endl;
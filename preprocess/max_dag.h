@@ -23,16 +23,36 @@
 #ifndef MAX_DAG_H
 #define MAX_DAG_H
 
-#include <map>
+#include "compact_graph.h"
+
 #include <vector>
 using namespace std;
 
+/*
+  The weighted graph is given as a CompactGraph. A MaxDAG object keeps
+  its working arrays between calls to get_result().
+
+  The nodes wait in an indexed 4-ary min-heap. A node's key is its
+  incoming weight, and then the time its weight was last changed, so
+  ties go to the node that has been waiting longest.
+*/
+
+template<class Index>
 class MaxDAG {
-  const vector<vector<pair<int, int> > > &weighted_graph;
+  // The following three are indexed by the graph's nodes.
+  vector<int> incoming_weights;
+  vector<int> stamps;
+  vector<int> heap_positions; // -1 once the node has been removed
+  vector<int> heap; // nodes, in heap order
+  int current_stamp;
   bool debug;
+
+  bool is_less(int node1, int node2) const;
+  void sift_up(int pos);
+  void sift_down(int pos);
+  void set_weight(int node, int weight);
 public:
-  MaxDAG(const vector<vector<pair<int, int> > > &graph) : weighted_graph(graph), 
-    debug(false) {}
-  vector<int> get_result();
+  MaxDAG() : debug(false) {}
+  void get_result(const CompactGraph<Index> &graph, vector<int> &result);
 };
 #endif
@@ -21,91 +21,335 @@
  *
  *********************************************************************/
 
+#include "condition_table.h"
 #include "helper_functions.h"
+#include "pipeline_context.h"
 #include "operator.h"
 #include "variable.h"
+#include "tokenizer.h"
+#include "sas_binary.h"
+#include "string_table.h"
 
 #include <cassert>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <fstream>
-#include <sstream>
 using namespace std;
 
-Operator::Operator(istream &in, const vector<Variable *> &variables) {
-  check_magic(in, "begin_operator");
-  in >> ws;
-  getline(in, name);
-  int count; // number of prevail conditions
-  in >> count;
+OperatorTable::OperatorTable(StringTable &the_strings,
+			     ConditionTable &the_conditions)
+  : strings(&the_strings), conditions(&the_conditions) {
+}
+
+void OperatorTable::read(Tokenizer &in, const vector<Variable *> &variables) {
+  Entry entry;
+  in.check_magic("begin_operator");
+  const char *name_text;
+  size_t name_length;
+  in.read_line(name_text, name_length);
+  entry.name_id = strings->intern(name_text, name_length);
+  entry.prevail_begin = prevails.size();
+  int count = in.read_int(); // number of prevail conditions
   for(int i = 0; i < count; i++) {
-    int varNo, val;
-    in >> varNo >> val;
-    prevail.push_back(Prevail(variables[varNo], val));
+    int varNo = in.read_int();
+    int val = in.read_int();
+    prevails.push_back(Operator::Prevail(variables[varNo], val));
   }
-  in >> count; // number of pre_post conditions
+  entry.prevail_end = prevails.size();
+  entry.pre_post_begin = effects.size();
+  // Blocking effects go after all pre_post effects of the operator.
+  vector<Operator::PrePost> pre_block;
+  count = in.read_int(); // number of pre_post conditions
   for(int i = 0; i < count; i++) {
-    int eff_conds;
-    vector<EffCond> ecs;
-    in >> eff_conds;
+    int first_cond = effect_conds.size();
+    int eff_conds = in.read_int();
     for(int j = 0; j < eff_conds; j++) {
-      int var, value;
-      in >> var >> value;
-      ecs.push_back(EffCond(variables[var], value));
+      int var = in.read_int();
+      int value = in.read_int();
+      effect_conds.push_back(Operator::EffCond(variables[var], value));
     }
     int varNo, val, newVal;
-    string funcCost;
+    const char *funcCost;
+    size_t funcCost_length;
+    bool have_funcCost_expression;
+    int run_cost = 0;
     float f_funcCost = 0;
-    in >> varNo >> val;
+    varNo = in.read_int();
+    val = in.read_int();
+    vector<Operator::PrePost> *target = &effects;
     if (val == -7 || val == -8){
-            in >> newVal;
-            if(eff_conds)
-              pre_block.push_back(PrePost(variables[varNo], ecs, val, newVal, float(-1)));
-            else
-              pre_block.push_back(PrePost(variables[varNo], val, newVal, float(-1)));
+            newVal = in.read_int();
+            pre_block.push_back(Operator::PrePost(variables[varNo], val, newVal, float(-1)));
+            target = &pre_block;
     }
     else if(val != -2 && (val != -3) && (val != -4) && (val != -5) && (val != -6))
     {
-        in >> newVal;
-        if(eff_conds)
-          pre_post.push_back(PrePost(variables[varNo], ecs, val, newVal, float(-1)));
-        else
-          pre_post.push_back(PrePost(variables[varNo], val, newVal, float(-1)));
+        newVal = in.read_int();
+        effects.push_back(Operator::PrePost(variables[varNo], val, newVal, float(-1)));
     }
     else
     {
-    	in >> funcCost >> varNo >> newVal;
-    	if (funcCost.find('(') == std::string::npos)
-    	{
-            istringstream buffer(funcCost);
-            buffer >> f_funcCost;
-            if(eff_conds)
-              pre_post.push_back(PrePost(variables[varNo], ecs, val, newVal, f_funcCost));
-            else
-              pre_post.push_back(PrePost(variables[varNo], val, newVal, f_funcCost));
-    	} else{
-            if(eff_conds)
-              pre_post.push_back(PrePost(variables[varNo], ecs, val, newVal, float(0),funcCost));
-            else
-              pre_post.push_back(PrePost(variables[varNo], val, newVal, float(0), funcCost));
-    	}
+    	in.read_token(funcCost, funcCost_length);
+    	have_funcCost_expression = memchr(funcCost, '(', funcCost_length) != 0;
+    	if (have_funcCost_expression)
+    	    run_cost = strings->intern(funcCost, funcCost_length);
+    	else
+    	    Tokenizer::parse_float(funcCost, funcCost_length, f_funcCost);
+    	varNo = in.read_int();
+    	newVal = in.read_int();
+    	if (!have_funcCost_expression)
+            effects.push_back(Operator::PrePost(variables[varNo], val, newVal, f_funcCost));
+    	else
+            effects.push_back(Operator::PrePost(variables[varNo], val, newVal, float(0), run_cost));
+    }
+    if(eff_conds) {
+      Operator::PrePost &added = target->back();
+      added.is_conditional_effect = true;
+      added.first_cond = first_cond;
+      added.cond_count = eff_conds;
     }
-
   }
-  in >> cost;
-  string s_aux = "";
-  in >> s_aux;
-  if(s_aux == "runtime"){
-	  have_runtime_cost = true;
-	  in >> runtime_cost;
+  entry.pre_block_begin = effects.size();
+  effects.insert(effects.end(), pre_block.begin(), pre_block.end());
+  entry.effects_end = effects.size();
+  entry.cost = in.read_float();
+  const char *s_aux;
+  size_t s_aux_length;
+  in.read_token(s_aux, s_aux_length);
+  if(in.token_equals(s_aux, s_aux_length, "runtime")){
+	  entry.have_runtime_cost = true;
+	  in.read_token(s_aux, s_aux_length);
+	  entry.runtime_cost_id = strings->intern(s_aux, s_aux_length);
   } else{
-	  have_runtime_cost = false;
-	  in >> s_aux;
+	  entry.have_runtime_cost = false;
+	  entry.runtime_cost_id = 0;
+	  in.skip_token();
   }
-  check_magic(in, "end_operator");
+  in.check_magic("end_operator");
+  intern_preconditions(entry);
+  entries.push_back(entry);
+}
+
+/* Binary encoding (see sas_binary.h): name, prevail conditions as
+   (var, val), effects and blocking effects (see below), cost and the
+   optional runtime cost expression. Each effect is written as var,
+   pre, post and a flags field; the flags say whether effect conditions
+   and a runtime cost expression follow, and whether f_cost differs from
+   its default (0 with a runtime cost expression, -1 otherwise). */
+enum {
+  CONDITIONAL_EFFECT = 1,
+  RUNTIME_COST_EFFECT = 2,
+  EXPLICIT_F_COST = 4
+};
+
+Operator::PrePost OperatorTable::read_binary_pre_post(
+  BinaryReader &in, const vector<Variable *> &variables) {
+  Variable *var = in.read_variable(variables);
+  int pre = in.read_int();
+  int post = in.read_int();
+  int flags = in.read_uint();
+  int first_cond = effect_conds.size();
+  int cond_count = 0;
+  if(flags & CONDITIONAL_EFFECT) {
+    cond_count = in.read_count();
+    for(int i = 0; i < cond_count; i++) {
+      Variable *cond_var = in.read_variable(variables);
+      effect_conds.push_back(Operator::EffCond(cond_var, in.read_int()));
+    }
+  }
+  Operator::PrePost pre_post(var, pre, post, -1);
+  if(flags & RUNTIME_COST_EFFECT)
+    pre_post = Operator::PrePost(var, pre, post, 0, in.read_string_id());
+  if(flags & EXPLICIT_F_COST)
+    pre_post.f_cost = in.read_float();
+  if(flags & CONDITIONAL_EFFECT) {
+    pre_post.is_conditional_effect = true;
+    pre_post.first_cond = first_cond;
+    pre_post.cond_count = cond_count;
+  }
+  return pre_post;
+}
+
+void OperatorTable::write_binary_pre_post(
+  BinaryWriter &out, const Operator::PrePost &pre_post) const {
+  out.write_uint(pre_post.var->get_index());
+  out.write_int(pre_post.pre);
+  out.write_int(pre_post.post);
+  float default_f_cost = pre_post.have_runtime_cost_effect ? 0 : -1;
+  int flags = 0;
+  if(pre_post.is_conditional_effect)
+    flags |= CONDITIONAL_EFFECT;
+  if(pre_post.have_runtime_cost_effect)
+    flags |= RUNTIME_COST_EFFECT;
+  if(pre_post.f_cost != default_f_cost)
+    flags |= EXPLICIT_F_COST;
+  out.write_uint(flags);
+  if(pre_post.is_conditional_effect) {
+    out.write_uint(pre_post.cond_count);
+    for(int i = 0; i < pre_post.cond_count; i++) {
+      const Operator::EffCond &cond = effect_conds[pre_post.first_cond + i];
+      out.write_uint(cond.var->get_index());
+      out.write_int(cond.cond);
+    }
+  }
+  if(pre_post.have_runtime_cost_effect)
+    out.write_string_id(pre_post.runtime_cost_effect_id);
+  if(flags & EXPLICIT_F_COST)
+    out.write_float(pre_post.f_cost);
+}
+
+void OperatorTable::read_binary(BinaryReader &in,
+				const vector<Variable *> &variables) {
+  Entry entry;
+  entry.name_id = in.read_string_id();
+  entry.prevail_begin = prevails.size();
+  int count = in.read_count();
+  for(int i = 0; i < count; i++) {
+    Variable *var = in.read_variable(variables);
+    prevails.push_back(Operator::Prevail(var, in.read_int()));
+  }
+  entry.prevail_end = prevails.size();
+  entry.pre_post_begin = effects.size();
+  count = in.read_count();
+  for(int i = 0; i < count; i++)
+    effects.push_back(read_binary_pre_post(in, variables));
+  entry.pre_block_begin = effects.size();
+  count = in.read_count();
+  for(int i = 0; i < count; i++)
+    effects.push_back(read_binary_pre_post(in, variables));
+  entry.effects_end = effects.size();
+  entry.cost = in.read_float();
+  entry.have_runtime_cost = in.read_bool();
+  entry.runtime_cost_id = entry.have_runtime_cost ? in.read_string_id() : 0;
+  intern_preconditions(entry);
+  entries.push_back(entry);
+}
+
+void Operator::write_binary(BinaryWriter &out) const {
+  const OperatorTable::Entry &entry = table->entries[index];
+  Span<Prevail> prevail = get_prevail();
+  Span<PrePost> pre_post = get_pre_post();
+  Span<PrePost> pre_block = get_pre_block();
+  out.write_string_id(entry.name_id);
+  out.write_uint(prevail.size());
+  for(int i = 0; i < prevail.size(); i++) {
+    out.write_uint(prevail[i].var->get_index());
+    out.write_int(prevail[i].prev);
+  }
+  out.write_uint(pre_post.size());
+  for(int i = 0; i < pre_post.size(); i++)
+    table->write_binary_pre_post(out, pre_post[i]);
+  out.write_uint(pre_block.size());
+  for(int i = 0; i < pre_block.size(); i++)
+    table->write_binary_pre_post(out, pre_block[i]);
+  out.write_float(entry.cost);
+  out.write_bool(entry.have_runtime_cost);
+  if(entry.have_runtime_cost)
+    out.write_string_id(entry.runtime_cost_id);
+}
+
+void OperatorTable::add_effect(const Operator::PrePost &pre_post,
+			       const OperatorTable &source) {
+  effects.push_back(pre_post);
+  effects.back().first_cond = effect_conds.size();
+  effect_conds.insert(effect_conds.end(),
+		      source.effect_conds.begin() + pre_post.first_cond,
+		      source.effect_conds.begin() + pre_post.first_cond +
+		      pre_post.cond_count);
+}
+
+void OperatorTable::intern_preconditions(Entry &entry) const {
+  vector<ConditionTable::Fact> facts;
+  for(int i = entry.prevail_begin; i < entry.prevail_end; i++)
+    facts.push_back(make_pair(prevails[i].var->get_index(), prevails[i].prev));
+  // Effects without a precondition and cost effects (-2 .. -6) add none.
+  for(int i = entry.pre_post_begin; i < entry.pre_block_begin; i++) {
+    int pre = effects[i].pre;
+    if(pre != -1 && (pre < -6 || pre > -2))
+      facts.push_back(make_pair(effects[i].var->get_index(), pre));
+  }
+  entry.precondition_id = conditions->intern(facts);
+}
+
+void OperatorTable::append(const OperatorTable &other) {
+  int prevail_offset = prevails.size();
+  int effect_offset = effects.size();
+  int cond_offset = effect_conds.size();
+  prevails.insert(prevails.end(), other.prevails.begin(), other.prevails.end());
+  effect_conds.insert(effect_conds.end(), other.effect_conds.begin(),
+		      other.effect_conds.end());
+  effects.reserve(effects.size() + other.effects.size());
+  for(int i = 0; i < other.effects.size(); i++) {
+    effects.push_back(other.effects[i]);
+    effects.back().first_cond += cond_offset;
+  }
+  entries.reserve(entries.size() + other.entries.size());
+  for(int i = 0; i < other.entries.size(); i++) {
+    Entry entry = other.entries[i];
+    entry.prevail_begin += prevail_offset;
+    entry.prevail_end += prevail_offset;
+    entry.pre_post_begin += effect_offset;
+    entry.pre_block_begin += effect_offset;
+    entry.effects_end += effect_offset;
+    entries.push_back(entry);
+  }
+}
+
+void OperatorTable::strip_unimportant_effects(const PipelineContext &context) {
+  // The kept entries are copied into a fresh table, which also drops
+  // the conditions of removed effects.
+  OperatorTable stripped(*strings, *conditions);
+  stripped.entries.reserve(entries.size());
+  stripped.prevails.reserve(prevails.size());
+  stripped.effects.reserve(effects.size());
+  stripped.effect_conds.reserve(effect_conds.size());
+  for(int i = 0; i < entries.size(); i++) {
+    const Entry &old_entry = entries[i];
+    Entry entry = old_entry;
+    entry.pre_post_begin = stripped.effects.size();
+    for(int j = old_entry.pre_post_begin; j < old_entry.pre_block_begin; j++)
+      if(context.get_level(effects[j].var) != -1)
+	stripped.add_effect(effects[j], *this);
+    entry.pre_block_begin = stripped.effects.size();
+    if(entry.pre_block_begin == entry.pre_post_begin)
+      continue; // redundant: no effects left
+    for(int j = old_entry.pre_block_begin; j < old_entry.effects_end; j++)
+      stripped.add_effect(effects[j], *this);
+    entry.effects_end = stripped.effects.size();
+    entry.prevail_begin = stripped.prevails.size();
+    stripped.prevails.insert(stripped.prevails.end(),
+			     prevails.begin() + old_entry.prevail_begin,
+			     prevails.begin() + old_entry.prevail_end);
+    entry.prevail_end = stripped.prevails.size();
+    stripped.intern_preconditions(entry);
+    stripped.entries.push_back(entry);
+  }
+  entries.swap(stripped.entries);
+  prevails.swap(stripped.prevails);
+  effects.swap(stripped.effects);
+  effect_conds.swap(stripped.effect_conds);
+}
+
+void OperatorTable::reorder(const vector<int> &order) {
+  assert(order.size() == entries.size());
+  // The entries refer to their ranges of the flat arrays, which stay
+  // where they are.
+  vector<Entry> reordered;
+  reordered.reserve(entries.size());
+  for(int i = 0; i < order.size(); i++)
+    reordered.push_back(entries[order[i]]);
+  entries.swap(reordered);
+}
+
+string Operator::get_name() const {
+  return table->strings->get(get_name_id());
 }
 
 void Operator::dump() const {
-  cout << name << ":" << endl;
+  Span<Prevail> prevail = get_prevail();
+  Span<PrePost> pre_post = get_pre_post();
+  cout << get_name() << ":" << endl;
   cout << "prevail:";
   for(int i = 0; i < prevail.size(); i++)
     cout << "  " << prevail[i].var->get_name() << " := " << prevail[i].prev;
@@ -113,10 +357,11 @@ void Operator::dump() const {
   cout << "pre-post:";
   for(int i = 0; i < pre_post.size(); i++) {
     if(pre_post[i].is_conditional_effect) {
+      Span<EffCond> effect_conds = get_effect_conds(pre_post[i]);
       cout << "  if (";
-      for(int j = 0; j < pre_post[i].effect_conds.size(); j++)
-	cout << pre_post[i].effect_conds[j].var->get_name() << " := " <<
-	  pre_post[i].effect_conds[j].cond;
+      for(int j = 0; j < effect_conds.size(); j++)
+	cout << effect_conds[j].var->get_name() << " := " <<
+	  effect_conds[j].cond;
       cout << ") then";
     }
     cout << " " << pre_post[i].var->get_name() << " : " << 
@@ -125,139 +370,115 @@ void Operator::dump() const {
   cout << endl;
 }
 
-void Operator::strip_unimportant_effects() {
-  int new_index = 0;
-  for(int i = 0; i < pre_post.size(); i++) {
-    if(pre_post[i].var->get_level() != -1)
-      pre_post[new_index++] = pre_post[i];
-  }
-  pre_post.erase(pre_post.begin() + new_index, pre_post.end());
-}
-
-bool Operator::is_redundant() const {
-  return pre_post.empty();
+void strip_operators(const PipelineContext &context, OperatorTable &operators) {
+  int old_count = operators.size();
+  operators.strip_unimportant_effects(context);
+  cout << operators.size() << " of " << old_count << " operators necessary." << endl;
 }
 
-void strip_operators(vector<Operator> &operators) {
-  int old_count = operators.size();
-  int new_index = 0;
-  for(int i = 0; i < operators.size(); i++) {
-    operators[i].strip_unimportant_effects();
-    if(!operators[i].is_redundant())
-      operators[new_index++] = operators[i];
+// Writes a runtime cost expression, replacing each variable reference
+// !<variable index>! by :<variable level>:. The expression is read in
+// place from the string table.
+static void write_runtime_cost(ofstream &outfile, int expression_id,
+			       const PipelineContext &context,
+			       const vector<Variable *> &variables) {
+  const char *pos;
+  size_t length;
+  context.get_strings().get(expression_id, pos, length);
+  const char *end = pos + length;
+  while(true) {
+    const char *open = static_cast<const char *>(memchr(pos, '!', end - pos));
+    const char *close = open ? static_cast<const char *>(
+      memchr(open + 1, '!', end - open - 1)) : 0;
+    if(!close) {
+      outfile.write(pos, end - pos);
+      return;
+    }
+    outfile.write(pos, open - pos);
+    // The closing '!' ends the number.
+    int var_no = atoi(open + 1);
+    outfile << ":" << context.get_level(variables[var_no]) << ":";
+    pos = close + 1;
   }
-  operators.erase(operators.begin() + new_index, operators.end());
-  cout << operators.size() << " of " << old_count << " operators necessary." << endl;
 }
 
-void Operator::generate_cpp_input(ofstream &outfile, vector<Variable *> variables) const {
+void Operator::generate_cpp_input(ofstream &outfile,
+				  const PipelineContext &context,
+				  const vector<Variable *> &variables,
+				  int op_no) const {
+  const OperatorTable::Entry &entry = table->entries[index];
+  Span<Prevail> prevail = get_prevail();
+  Span<PrePost> pre_post = get_pre_post();
+  Span<PrePost> pre_block = get_pre_block();
   outfile << "begin_operator" << endl;
-  outfile << name << endl;
+  if(context.get_operator_names() == OPERATOR_NAMES_INLINE)
+    table->strings->write(outfile, entry.name_id);
+  else
+    outfile << op_no; // the name is in the operator name table
+  outfile << endl;
 
   outfile << prevail.size() << endl;
   for(int i = 0; i < prevail.size(); i++) {
-    assert(prevail[i].var->get_level() != -1);
-    if(prevail[i].var->get_level() != -1)
-      outfile << prevail[i].var->get_level() << " "<< prevail[i].prev << endl;
+    assert(context.get_level(prevail[i].var) != -1);
+    if(context.get_level(prevail[i].var) != -1)
+      outfile << context.get_level(prevail[i].var) << " "<< prevail[i].prev << endl;
   }
 
   outfile << pre_post.size() << endl;
   for(int i = 0; i < pre_post.size(); i++) { 
-    assert(pre_post[i].var->get_level() != -1);
+    assert(context.get_level(pre_post[i].var) != -1);
     if(pre_post[i].is_conditional_effect) {
-      outfile << pre_post[i].effect_conds.size() << endl;
-      for(int j = 0; j < pre_post[i].effect_conds.size(); j++)
-	outfile << pre_post[i].effect_conds[j].var->get_level() << " " <<
-	  pre_post[i].effect_conds[j].cond << endl;
+      Span<EffCond> effect_conds = get_effect_conds(pre_post[i]);
+      outfile << effect_conds.size() << endl;
+      for(int j = 0; j < effect_conds.size(); j++)
+	outfile << context.get_level(effect_conds[j].var) << " " <<
+	  effect_conds[j].cond << endl;
     } else {
       outfile << "0" << endl;
     }
 
     if((pre_post[i].pre != -2) && (pre_post[i].pre != -3) && (pre_post[i].pre != -4) && (pre_post[i].pre != -5) && (pre_post[i].pre != -6))
-    	outfile << pre_post[i].var->get_level() << " " << pre_post[i].pre << " "
+    	outfile << context.get_level(pre_post[i].var) << " " << pre_post[i].pre << " "
 	    	<< pre_post[i].post << endl;
     else
     {
     	if (pre_post[i].have_runtime_cost_effect){
-
-    		string s_effect = pre_post[i].runtime_cost_effect;
-    		string s_eff_aux = s_effect;
-    		while(s_effect.find("!") != string::npos){
-    			string var = "";
-    			int i_var;
-    			int var_level = 0;
-    			s_eff_aux = s_eff_aux.substr(s_eff_aux.find("!") + 1, s_eff_aux.length() - 1);
-    			var = s_eff_aux.substr(0, s_eff_aux.find("!"));
-    			s_eff_aux = s_eff_aux.substr(s_eff_aux.find("!") + 1, s_eff_aux.length() - 1);
-    			stringstream strm(var);
-    			strm >> i_var;
-    			strm.str(std::string());
-    			var_level = variables[i_var]->get_level();
-    			std::ostringstream strm_var;
-    			strm_var << var_level;
-
-    			string from = "!" + var + "!";
-    			string to = ":" + strm_var.str() + ":";
-    		    size_t start_pos = 0;
-    		    while((start_pos = s_effect.find(from, start_pos)) != std::string::npos) {
-    		    	s_effect.replace(start_pos, from.length(), to);
-    		        start_pos += to.length(); // Handles case where 'to' is a substring of 'from'
-    		    }
-    		}
-
-    		outfile << pre_post[i].var->get_level() << " " << pre_post[i].pre << " "
-    		    	<< pre_post[i].post << " " << s_effect << endl;
+    		outfile << context.get_level(pre_post[i].var) << " " << pre_post[i].pre << " "
+    		    	<< pre_post[i].post << " ";
+    		write_runtime_cost(outfile, pre_post[i].runtime_cost_effect_id, context,
+			       variables);
+    		outfile << endl;
     	}
     	else
-    		outfile << pre_post[i].var->get_level() << " " << pre_post[i].pre << " "
+    		outfile << context.get_level(pre_post[i].var) << " " << pre_post[i].pre << " "
     		    	<< pre_post[i].post << " " << pre_post[i].f_cost << endl;
     }
   }
 
   outfile << pre_block.size() << endl;
   for(int i = 0; i < pre_block.size(); i++) {
-	  assert(pre_block[i].var->get_level() != -1);
+	  assert(context.get_level(pre_block[i].var) != -1);
 	  if(pre_block[i].is_conditional_effect) {
-	    outfile << pre_block[i].effect_conds.size() << endl;
-	    for(int j = 0; j < pre_block[i].effect_conds.size(); j++)
-	    	outfile << pre_block[i].effect_conds[j].var->get_level() << " " <<
-			  pre_post[i].effect_conds[j].cond << endl;
+	    Span<EffCond> effect_conds = get_effect_conds(pre_block[i]);
+	    Span<EffCond> written_conds = get_effect_conds(pre_post[i]);
+	    outfile << effect_conds.size() << endl;
+	    for(int j = 0; j < effect_conds.size(); j++)
+	    	outfile << context.get_level(effect_conds[j].var) << " " <<
+			  written_conds[j].cond << endl;
 	  } else {
 	    outfile << "0" << endl;
 	  }
 
-	  outfile << pre_block[i].var->get_level() << " " << pre_block[i].pre << " "
+	  outfile << context.get_level(pre_block[i].var) << " " << pre_block[i].pre << " "
 	  	    	<< pre_block[i].post << endl;
   }
 
-  outfile << cost << endl;
-  if(have_runtime_cost)
+  outfile << entry.cost << endl;
+  if(entry.have_runtime_cost)
   {
 	  outfile << "runtime" << endl;
-	  string s_effect = runtime_cost;
-	  string s_eff_aux = s_effect;
-	  while(s_effect.find("!") != string::npos){
-	  		string var = "";
-	   		int i_var;
-	   		int var_level = 0;
-	  		s_eff_aux = s_eff_aux.substr(s_eff_aux.find("!") + 1, s_eff_aux.length() - 1);
-	   		var = s_eff_aux.substr(0, s_eff_aux.find("!"));
-	   		s_eff_aux = s_eff_aux.substr(s_eff_aux.find("!") + 1, s_eff_aux.length() - 1);
-	   		stringstream strm(var);
-	   		strm >> i_var;
-	   		strm.str(std::string());
-	   		var_level = variables[i_var]->get_level();
-	   		std::ostringstream strm_var;
-	   		strm_var << var_level;
-	   		string from = "!" + var + "!";
-	   		string to = ":" + strm_var.str() + ":";
-      	    size_t start_pos = 0;
-  		    while((start_pos = s_effect.find(from, start_pos)) != std::string::npos) {
-      		    	s_effect.replace(start_pos, from.length(), to);
-      		        start_pos += to.length(); // Handles case where 'to' is a substring of 'from'
-      		}
-      }
-	  outfile << s_effect << endl;
+	  write_runtime_cost(outfile, entry.runtime_cost_id, context, variables);
+	  outfile << endl;
   }else{
 	  outfile << "no-run" << endl;
 	  outfile << "-" << endl;
@@ -24,14 +24,33 @@
 #ifndef OPERATOR_H
 #define OPERATOR_H
 
+#include "span.h"
+
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <vector>
 using namespace std;
 
+class BinaryReader;
+class BinaryWriter;
+class ConditionTable;
+class OperatorTable;
+class PipelineContext;
+class StringTable;
+class Tokenizer;
 class Variable;
 
+/*
+  The operators of a task live in an OperatorTable: flat arrays of
+  prevail conditions, effects and effect conditions shared by all
+  operators, and per operator the ranges it uses in them. Names and
+  runtime cost expressions are interned in the table's StringTable,
+  preconditions in its ConditionTable. An Operator is a lightweight
+  view of one table entry; it stays valid as long as the table is not
+  modified.
+*/
+
 class Operator {
 public:
   struct Prevail {
@@ -49,53 +68,121 @@ public:
     int pre, post;
     float f_cost;
     bool have_runtime_cost_effect;
-    string runtime_cost_effect;
+    int runtime_cost_effect_id; // in the table's strings
     bool is_conditional_effect;
-    vector<EffCond> effect_conds;
+    // effect conditions, in the effect condition array of the table
+    int first_cond, cond_count;
     PrePost(Variable *v, int pr, int po, float f_c) : var(v), pre(pr), post(po), f_cost(f_c){
-      is_conditional_effect = false;
       have_runtime_cost_effect = false;
-      runtime_cost_effect = "";}
+      runtime_cost_effect_id = 0;
+      is_conditional_effect = false;
+      first_cond = cond_count = 0;}
 
-    PrePost(Variable *v, int pr, int po, float f_c, std::string& run_cost) : var(v), pre(pr), post(po),
-    		f_cost(f_c), runtime_cost_effect(run_cost){
+    PrePost(Variable *v, int pr, int po, float f_c, int run_cost) : var(v), pre(pr), post(po),
+    		f_cost(f_c), runtime_cost_effect_id(run_cost){
+      have_runtime_cost_effect = true;
       is_conditional_effect = false;
-      have_runtime_cost_effect = true;}
-
-    PrePost(Variable *v, vector<EffCond> ecs, int pr, int po, float f_c) : var(v), pre(pr),
-	 post(po), f_cost(f_c), effect_conds(ecs) {
-    	is_conditional_effect = true;
-    	have_runtime_cost_effect = false;
-    	runtime_cost_effect = "";}
-
-    PrePost(Variable *v, vector<EffCond> ecs, int pr, int po, float f_c, std::string& run_cost) : var(v), pre(pr),
-	 post(po), f_cost(f_c), runtime_cost_effect(run_cost), effect_conds(ecs){
-    	is_conditional_effect = true;
-    	have_runtime_cost_effect = true;}
+      first_cond = cond_count = 0;}
   };
   
 private:
-  string name;
-  vector<Prevail> prevail;      // var, val
-  vector<PrePost> pre_post; // var, old-val, new-val
-  vector<PrePost> pre_block;
-  float cost;
-  bool have_runtime_cost;
-  string runtime_cost;
+  const OperatorTable *table;
+  int index;
 public:
-  Operator(istream &in, const vector<Variable *> &variables);
-
-  void strip_unimportant_effects();
-  bool is_redundant() const;
+  Operator(const OperatorTable &the_table, int the_index)
+    : table(&the_table), index(the_index) {}
+  void write_binary(BinaryWriter &out) const;
 
   void dump() const;
-  void generate_cpp_input(ofstream &outfile, vector<Variable *> variables) const;
-  string get_name() const {return name;}
-  const vector<Prevail> &get_prevail() const {return prevail;}
-  const vector<PrePost> &get_pre_post() const {return pre_post;}
-  const vector<PrePost> &get_pre_block() const {return pre_block;}
+  void generate_cpp_input(ofstream &outfile, const PipelineContext &context,
+			  const vector<Variable *> &variables,
+			  int op_no) const;
+  string get_name() const;
+  int get_name_id() const;
+  // Prevail conditions and preconditions of the effects, as a set in
+  // the table's conditions.
+  int get_precondition_id() const;
+  Span<Prevail> get_prevail() const;
+  Span<PrePost> get_pre_post() const;
+  Span<PrePost> get_pre_block() const;
+  Span<EffCond> get_effect_conds(const PrePost &pre_post) const;
+};
+
+class OperatorTable {
+  friend class Operator;
+  struct Entry {
+    int name_id; // in strings
+    float cost;
+    bool have_runtime_cost;
+    int runtime_cost_id; // in strings
+    int precondition_id; // in conditions
+    // The effects of an operator are its pre_post effects followed by
+    // its pre_block effects.
+    int prevail_begin, prevail_end;
+    int pre_post_begin, pre_block_begin, effects_end;
+  };
+  vector<Entry> entries;
+  vector<Operator::Prevail> prevails;
+  vector<Operator::PrePost> effects;
+  vector<Operator::EffCond> effect_conds;
+  StringTable *strings;
+  ConditionTable *conditions;
+
+  Operator::PrePost read_binary_pre_post(BinaryReader &in,
+					 const vector<Variable *> &variables);
+  void write_binary_pre_post(BinaryWriter &out,
+			     const Operator::PrePost &pre_post) const;
+  void add_effect(const Operator::PrePost &pre_post,
+		  const OperatorTable &source);
+  void intern_preconditions(Entry &entry) const;
+public:
+  OperatorTable(StringTable &strings, ConditionTable &conditions);
+  void reserve(int count) {entries.reserve(count);}
+  // Both read one operator and append it to the table.
+  void read(Tokenizer &in, const vector<Variable *> &variables);
+  void read_binary(BinaryReader &in, const vector<Variable *> &variables);
+  void append(const OperatorTable &other);
+
+  // Removes effects on unimportant variables, then operators without
+  // effects.
+  void strip_unimportant_effects(const PipelineContext &context);
+  // Operator i becomes the former operator order[i].
+  void reorder(const vector<int> &order);
+
+  int size() const {return entries.size();}
+  Operator operator[](int i) const {return Operator(*this, i);}
 };
 
-extern void strip_operators(vector<Operator> &operators);
+inline int Operator::get_name_id() const {
+  return table->entries[index].name_id;
+}
+
+inline int Operator::get_precondition_id() const {
+  return table->entries[index].precondition_id;
+}
+
+inline Span<Operator::Prevail> Operator::get_prevail() const {
+  const OperatorTable::Entry &entry = table->entries[index];
+  return make_span(table->prevails, entry.prevail_begin, entry.prevail_end);
+}
+
+inline Span<Operator::PrePost> Operator::get_pre_post() const {
+  const OperatorTable::Entry &entry = table->entries[index];
+  return make_span(table->effects, entry.pre_post_begin, entry.pre_block_begin);
+}
+
+inline Span<Operator::PrePost> Operator::get_pre_block() const {
+  const OperatorTable::Entry &entry = table->entries[index];
+  return make_span(table->effects, entry.pre_block_begin, entry.effects_end);
+}
+
+inline Span<Operator::EffCond> Operator::get_effect_conds(
+  const PrePost &pre_post) const {
+  return make_span(table->effect_conds, pre_post.first_cond,
+		   pre_post.first_cond + pre_post.cond_count);
+}
+
+extern void strip_operators(const PipelineContext &context,
+			    OperatorTable &operators);
 
 #endif
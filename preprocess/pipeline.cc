@@ -0,0 +1,142 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+#include "pipeline.h"
+#include "helper_functions.h"
+#include "successor_generator.h"
+#include "causal_graph.h"
+#include "domain_transition_graph.h"
+#include "state.h"
+#include "operator.h"
+#include "axiom.h"
+#include "variable.h"
+#include "tokenizer.h"
+#include "sas_binary.h"
+#include "pipeline_context.h"
+
+#include <iostream>
+using namespace std;
+
+PreprocessOptions::PreprocessOptions()
+  : input(0), name(0), prefix(0), renumber_operators(false),
+    sg_stats(false), arena_stats(false) {
+}
+
+void run_preprocess(const PreprocessOptions &options,
+		    PipelineContext &context) {
+  string metric;
+  vector<Variable *> variables;
+  vector<Variable> internal_variables;
+  State initial_state;
+  vector<pair<Variable *, int> > goals;
+  OperatorTable operators(context.get_strings(), context.get_conditions());
+  vector<Axiom> axioms;
+  vector<DomainTransitionGraph> transition_graphs;
+  string name = "";
+  vector<Variable *> shared_vars;
+  vector<int> shared_vars_number;
+
+  Tokenizer in(options.input);
+
+  // Binary tasks (see sas_binary.h) are recognized by their magic
+  // word and read in one go.
+  bool binary_input = is_binary_task(in);
+  if(binary_input) {
+    in.load_remaining();
+    BinaryReader binary_in(in.position(), in.data_end(),
+			   context.get_strings());
+    read_binary_problem_description
+      (context, binary_in, name, metric, internal_variables, variables,
+       initial_state, goals, operators, axioms, shared_vars,
+       shared_vars_number);
+  } else {
+    name = in.read_string();
+  }
+  if(options.name)
+	  name = options.name;
+  if(name == "gen")
+	  name = "";
+  string filename(options.input);
+  string prefix = "";
+  string s_aux = "";
+  if(options.prefix) {
+	  prefix = options.prefix;
+  } else if(filename != "-") {
+	  while(filename.find("/") != string::npos)
+	  {
+		  filename = filename.substr(filename.find("/") + 1, filename.length());
+	  }
+	  s_aux = filename.substr(0, filename.find("_"));
+	  if(s_aux != "output")
+	  {
+		  cout << "suffix is " + filename + " --> " + s_aux << endl;
+		  prefix = s_aux;
+	  }
+  }
+
+  if(!binary_input)
+    read_preprocessed_problem_description
+      (context, in, metric, internal_variables, variables, initial_state,
+       goals, operators, axioms, shared_vars, shared_vars_number);
+  //dump_preprocessed_problem_description
+  //  (variables, initial_state, goals, operators, axioms);
+
+  // Everything computed from here on is kept in the context, so the
+  // task itself is not modified beyond stripping the operators and
+  // axioms.
+  context.set_variable_count(variables.size());
+
+  cout << "Building causal graph..." << endl;
+  CausalGraph causal_graph(context, variables, operators, axioms, goals);
+  const vector<Variable *> &ordering = causal_graph.get_variable_ordering();
+  bool cg_acyclic = causal_graph.is_acyclic();
+
+  // Remove unnecessary effects from operators and axioms, then remove
+  // operators and axioms without effects.
+  strip_operators(context, operators);
+  strip_axioms(context, axioms);
+  if(options.renumber_operators)
+    renumber_operators(context, ordering, operators);
+
+  cout << "Building domain transition graphs..." << endl;
+  build_DTGs(context, ordering, variables, operators, axioms,
+	     transition_graphs);
+  //dump_DTGs(ordering, transition_graphs);
+  bool solveable_in_poly_time = false;
+  if(cg_acyclic)
+    solveable_in_poly_time = are_DTGs_strongly_connected(transition_graphs);
+  cout << "solveable in poly time " << solveable_in_poly_time << endl;
+  cout << "Building successor generator..." << endl;
+  SuccessorGenerator successor_generator(context, ordering, operators);
+  // successor_generator.dump();
+  if(options.sg_stats)
+    successor_generator.report(cout);
+
+  cout << "Writing output..." << endl;
+  generate_cpp_input(context, solveable_in_poly_time, ordering, metric,
+		     initial_state, goals, operators, axioms,
+		     successor_generator, transition_graphs, causal_graph,
+		     name, shared_vars, shared_vars_number, variables, prefix);
+  cout << "done" << endl << endl;
+  if(options.arena_stats) {
+    context.get_task_arena().report(cout);
+    context.get_graph_arena().report(cout);
+  }
+  // The arenas are released in bulk with the context.
+}
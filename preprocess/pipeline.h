@@ -0,0 +1,54 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+/*
+  The preprocessing pipeline: reads a task, builds the causal graph,
+  the domain transition graphs and the successor generator, and writes
+  the output file for the search.
+*/
+
+class PipelineContext;
+
+// Settings of a run that are not kept in the PipelineContext.
+struct PreprocessOptions {
+  const char *input; // output.sas, a binary task, or "-" for stdin
+  // When reading from stdin or a FIFO, translate may still be writing
+  // the task; the name and prefix can then be given explicitly instead
+  // of being taken from the input and its path. 0 if not given.
+  const char *name;
+  const char *prefix;
+  bool renumber_operators;
+  bool sg_stats;
+  bool arena_stats;
+
+  PreprocessOptions();
+};
+
+// Preprocesses the task with the settings of the context, which must
+// not have been used for another run, and writes the output file to
+// the current directory. Runs with separate contexts can proceed in
+// parallel threads, as long as their output files differ.
+void run_preprocess(const PreprocessOptions &options,
+		    PipelineContext &context);
+
+#endif
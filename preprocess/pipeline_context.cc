@@ -0,0 +1,48 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+
+#include "pipeline_context.h"
+
+#include <cassert>
+using namespace std;
+
+PipelineContext::PipelineContext()
+  : task_arena("task"), graph_arena("graphs"), conditions(graph_arena),
+    parse_threads(1), do_not_prune_variables(false),
+    operator_names(OPERATOR_NAMES_INLINE),
+    any_value_transitions(false),
+    successor_generator_encoding(SG_ENCODING_DENSE),
+    switch_order(SWITCH_ORDER_INDEX), operator_ranges(false) {
+}
+
+void PipelineContext::set_variable_count(int variable_count) {
+  levels.assign(variable_count, -1);
+  necessary.assign(variable_count, false);
+}
+
+void PipelineContext::set_level(const Variable *var, int level) {
+  assert(levels[var->get_index()] == -1);
+  levels[var->get_index()] = level;
+}
+
+void PipelineContext::set_necessary(const Variable *var) {
+  assert(!necessary[var->get_index()]);
+  necessary[var->get_index()] = true;
+}
@@ -0,0 +1,141 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+
+#ifndef PIPELINE_CONTEXT_H
+#define PIPELINE_CONTEXT_H
+
+/*
+  State of one preprocessing run (see run_preprocess() in pipeline.h).
+
+  The context owns the memory of the run: the string and condition
+  tables the task is interned in, and the arenas for the task and the
+  graphs built from it. Everything read or built by the run refers to
+  them, so the context must outlive it. The tables and arenas lock, so
+  the parser threads of a run can share them.
+
+  The causal graph decides which variables are necessary and assigns
+  their levels; the DTGs, the successor generator and the writers read
+  them from here. Nothing is shared between contexts, so separate runs
+  can proceed in parallel threads, each with its own context.
+*/
+
+#include "arena.h"
+#include "condition_table.h"
+#include "string_table.h"
+#include "variable.h"
+
+#include <vector>
+using namespace std;
+
+// Where generate_cpp_input writes the operator names. Outside inline
+// mode the name line of each operator holds its number, and the names
+// follow in that order in a trailing begin_operator_names section or
+// in a sidecar file <output>.names, so the search can skip them until
+// it extracts a plan. The section is the count followed by one name
+// per line; there are no byte offsets, as the names are meant to be
+// read sequentially, all at once, and looked up by number in memory.
+enum OperatorNameMode {
+  OPERATOR_NAMES_INLINE,
+  OPERATOR_NAMES_SECTION,
+  OPERATOR_NAMES_SIDECAR
+};
+
+// How generate_cpp_input writes the children of the successor
+// generator's switches; see successor_generator.h for the format.
+enum SuccessorGeneratorEncoding {
+  SG_ENCODING_DENSE,
+  SG_ENCODING_EMPTY_RUNS,
+  SG_ENCODING_SPARSE
+};
+
+// How the successor generator picks the variable to switch on: in order
+// of variable index, or the variable that filters out the most
+// operators per lookup (see SuccessorGenerator::assign_buckets_by_cost).
+enum SwitchOrder {
+  SWITCH_ORDER_INDEX,
+  SWITCH_ORDER_COST
+};
+
+class PipelineContext {
+  Arena task_arena;  // data read from the task
+  Arena graph_arena; // graph structures built from it
+  StringTable strings;
+  ConditionTable conditions; // stored in graph_arena
+  int parse_threads;
+
+  // indexed by variable index
+  vector<int> levels; // -1 while unassigned, and for unimportant variables
+  vector<bool> necessary;
+  bool do_not_prune_variables;
+  OperatorNameMode operator_names;
+  bool any_value_transitions;
+  SuccessorGeneratorEncoding successor_generator_encoding;
+  SwitchOrder switch_order;
+  bool operator_ranges;
+
+  PipelineContext(const PipelineContext &copy);
+  PipelineContext &operator=(const PipelineContext &copy);
+public:
+  PipelineContext();
+
+  Arena &get_task_arena() {return task_arena;}
+  Arena &get_graph_arena() {return graph_arena;}
+  StringTable &get_strings() {return strings;}
+  const StringTable &get_strings() const {return strings;}
+  ConditionTable &get_conditions() {return conditions;}
+  const ConditionTable &get_conditions() const {return conditions;}
+  // Number of threads used to parse the operator and axiom sections;
+  // 0 means one per core.
+  void set_parse_threads(int count) {parse_threads = count;}
+  int get_parse_threads() const {return parse_threads;}
+
+  // Call once the variables are read, before any level is set.
+  void set_variable_count(int variable_count);
+  void set_do_not_prune_variables(bool value) {do_not_prune_variables = value;}
+  bool get_do_not_prune_variables() const {return do_not_prune_variables;}
+  void set_operator_names(OperatorNameMode mode) {operator_names = mode;}
+  OperatorNameMode get_operator_names() const {return operator_names;}
+  // Whether DTGs keep effects without a precondition as one transition
+  // from any value, and write them in a separate list, instead of one
+  // transition per source value.
+  void set_any_value_transitions(bool value) {any_value_transitions = value;}
+  bool get_any_value_transitions() const {return any_value_transitions;}
+  void set_successor_generator_encoding(SuccessorGeneratorEncoding encoding) {
+    successor_generator_encoding = encoding;
+  }
+  SuccessorGeneratorEncoding get_successor_generator_encoding() const {
+    return successor_generator_encoding;
+  }
+  void set_switch_order(SwitchOrder order) {switch_order = order;}
+  SwitchOrder get_switch_order() const {return switch_order;}
+  // Whether the successor generator writes lists of consecutive
+  // operators as ranges.
+  void set_operator_ranges(bool value) {operator_ranges = value;}
+  bool get_operator_ranges() const {return operator_ranges;}
+
+  void set_level(const Variable *var, int level);
+  int get_level(const Variable *var) const {return levels[var->get_index()];}
+  void set_necessary(const Variable *var);
+  bool is_necessary(const Variable *var) const {
+    return necessary[var->get_index()];
+  }
+};
+
+#endif
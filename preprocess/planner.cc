@@ -21,93 +21,93 @@
  *
  *********************************************************************/
 
-/* Main file, keeps all important variables.
- * Calls functions from "helper_functions" to read in input (variables, operators, 
- * goals, initial state),
- * then calls functions to build causal graph, domain_transition_graphs and 
- * successor generator
- * finally prints output to file "output"
+/* Main file. Parses the options into a PipelineContext and the
+ * PreprocessOptions, then runs the pipeline (see "pipeline.h"): read in
+ * input (variables, operators, goals, initial state), build causal graph,
+ * domain_transition_graphs and successor generator, and finally print
+ * output to file "output"
  */
 
-#include "helper_functions.h"
-#include "successor_generator.h"
-#include "causal_graph.h"
-#include "domain_transition_graph.h"
-#include "state.h"
-#include "operator.h"
-#include "axiom.h"
-#include "variable.h"
+#include "pipeline.h"
+#include "pipeline_context.h"
+#include <cstdlib>
 #include <iostream>
 using namespace std;
 
 int main(int argc, const char **argv) {
-  string metric;
-  vector<Variable *> variables;
-  vector<Variable> internal_variables;
-  State initial_state;
-  vector<pair<Variable *, int> > goals;
-  vector<Operator> operators;
-  vector<Axiom> axioms;
-  vector<DomainTransitionGraph> transition_graphs;
-  string name = "";
-  vector<Variable *> shared_vars;
-  vector<int> shared_vars_number;
-
+  bool do_not_prune_variables = false;
   if(argc != 1) {
       cout << "*** do not perform relevance analysis ***" << endl;
-      g_do_not_prune_variables = true;
+      do_not_prune_variables = true;
   }
-
-  std::fstream fs;
-  fs.open (argv[1], std::fstream::in);
-
-  fs >> name;
-  if(name == "gen")
-	  name = "";
-  string filename(argv[1]);
-  string prefix = "";
-  string s_aux = "";
-  while(filename.find("/") != string::npos)
-  {
-	  filename = filename.substr(filename.find("/") + 1, filename.length());
+  if(argc < 2) {
+    cout << "usage: " << argv[0] << " <output.sas | - > [options]" << endl;
+    return 1;
   }
-  s_aux = filename.substr(0, filename.find("_"));
-  if(s_aux != "output")
-  {
-	  cout << "suffix is " + filename + " --> " + s_aux << endl;
-	  prefix = s_aux;
+  PreprocessOptions options;
+  options.input = argv[1];
+  PipelineContext context;
+  context.set_do_not_prune_variables(do_not_prune_variables);
+  for(int i = 2; i < argc; i++) {
+    string arg = argv[i];
+    if(arg == "--parallel-parse")
+      context.set_parse_threads(0);
+    else if(arg == "--parse-threads" && i + 1 < argc)
+      context.set_parse_threads(atoi(argv[++i]));
+    else if(arg == "--name" && i + 1 < argc)
+      options.name = argv[++i];
+    else if(arg == "--prefix" && i + 1 < argc)
+      options.prefix = argv[++i];
+    else if(arg == "--arena-stats")
+      options.arena_stats = true;
+    else if(arg == "--dtg-any-value")
+      context.set_any_value_transitions(true);
+    else if(arg == "--sg-stats")
+      options.sg_stats = true;
+    else if(arg == "--renumber-operators")
+      options.renumber_operators = true;
+    else if(arg == "--sg-ranges")
+      context.set_operator_ranges(true);
+    else if(arg == "--sg-order" && i + 1 < argc) {
+      string mode = argv[++i];
+      if(mode == "index")
+	context.set_switch_order(SWITCH_ORDER_INDEX);
+      else if(mode == "cost")
+	context.set_switch_order(SWITCH_ORDER_COST);
+      else {
+	cout << "Unknown switch order " << mode << "." << endl;
+	return 1;
+      }
+    }
+    else if(arg == "--sg-empty-runs")
+      context.set_successor_generator_encoding(SG_ENCODING_EMPTY_RUNS);
+    else if(arg == "--sg-encoding" && i + 1 < argc) {
+      string mode = argv[++i];
+      if(mode == "dense")
+	context.set_successor_generator_encoding(SG_ENCODING_DENSE);
+      else if(mode == "runs")
+	context.set_successor_generator_encoding(SG_ENCODING_EMPTY_RUNS);
+      else if(mode == "sparse")
+	context.set_successor_generator_encoding(SG_ENCODING_SPARSE);
+      else {
+	cout << "Unknown successor generator encoding " << mode << "." << endl;
+	return 1;
+      }
+    }
+    else if(arg == "--operator-names" && i + 1 < argc) {
+      string mode = argv[++i];
+      if(mode == "inline")
+	context.set_operator_names(OPERATOR_NAMES_INLINE);
+      else if(mode == "section")
+	context.set_operator_names(OPERATOR_NAMES_SECTION);
+      else if(mode == "sidecar")
+	context.set_operator_names(OPERATOR_NAMES_SIDECAR);
+      else {
+	cout << "Unknown operator name mode " << mode << "." << endl;
+	return 1;
+      }
+    }
   }
 
-  read_preprocessed_problem_description
-    (fs, metric, internal_variables, variables, initial_state, goals, operators, axioms, shared_vars, shared_vars_number);
-  //dump_preprocessed_problem_description
-  //  (variables, initial_state, goals, operators, axioms);
-  
-  cout << "Building causal graph..." << endl;
-  CausalGraph causal_graph(variables, operators, axioms, goals);
-  const vector<Variable *> &ordering = causal_graph.get_variable_ordering();
-  bool cg_acyclic = causal_graph.is_acyclic();
-
-  // Remove unnecessary effects from operators and axioms, then remove
-  // operators and axioms without effects.
-  strip_operators(operators);
-  strip_axioms(axioms);
-
-  cout << "Building domain transition graphs..." << endl;
-  build_DTGs(ordering, operators, axioms, transition_graphs);
-  //dump_DTGs(ordering, transition_graphs);
-  bool solveable_in_poly_time = false;
-  if(cg_acyclic)
-    solveable_in_poly_time = are_DTGs_strongly_connected(transition_graphs);
-  cout << "solveable in poly time " << solveable_in_poly_time << endl;
-  cout << "Building successor generator..." << endl;
-  SuccessorGenerator successor_generator(ordering, operators);
-  // successor_generator.dump();
-
-  cout << "Writing output..." << endl;
-  generate_cpp_input(solveable_in_poly_time, ordering, metric, initial_state, 
-		     goals, operators, axioms, successor_generator, 
-		     transition_graphs, causal_graph, name, shared_vars, shared_vars_number,
-			 variables, prefix);
-  cout << "done" << endl << endl;
+  run_preprocess(options, context);
 }
@@ -0,0 +1,369 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+#include "sas_binary.h"
+#include "axiom.h"
+#include "operator.h"
+#include "pipeline_context.h"
+#include "state.h"
+#include "string_table.h"
+#include "tokenizer.h"
+#include "variable.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+using namespace std;
+
+const char *const SAS_BINARY_MAGIC = "SASB";
+const unsigned int SAS_BINARY_VERSION = 1;
+
+static const int TAG_LENGTH = 4;
+static const int SECTION_LENGTH_BYTES = 8;
+
+BinaryWriter::BinaryWriter(const StringTable &the_string_table)
+  : string_table(&the_string_table), section_start(0) {
+}
+
+void BinaryWriter::write_raw(const char *bytes, size_t length) {
+  body.insert(body.end(), bytes, bytes + length);
+}
+
+void BinaryWriter::begin_section(const char *tag) {
+  write_raw(tag, TAG_LENGTH);
+  section_start = body.size();
+  body.resize(body.size() + SECTION_LENGTH_BYTES);
+}
+
+void BinaryWriter::end_section() {
+  size_t length = body.size() - section_start - SECTION_LENGTH_BYTES;
+  for(int i = 0; i < SECTION_LENGTH_BYTES; i++) {
+    body[section_start + i] = length & 0xff;
+    length >>= 8;
+  }
+}
+
+void BinaryWriter::write_uint(unsigned long value) {
+  while(value >= 0x80) {
+    body.push_back((value & 0x7f) | 0x80);
+    value >>= 7;
+  }
+  body.push_back(value);
+}
+
+void BinaryWriter::write_int(long value) {
+  // zigzag: 0, -1, 1, -2, ... -> 0, 1, 2, 3, ...
+  unsigned long bits = value;
+  write_uint(value < 0 ? ~(bits << 1) : bits << 1);
+}
+
+void BinaryWriter::write_float(float value) {
+  unsigned int bits;
+  memcpy(&bits, &value, sizeof(bits));
+  for(int i = 0; i < 4; i++) {
+    body.push_back(bits & 0xff);
+    bits >>= 8;
+  }
+}
+
+void BinaryWriter::write_string(const string &str) {
+  map<string, int>::iterator it = string_ids.find(str);
+  if(it == string_ids.end()) {
+    it = string_ids.insert(make_pair(str, int(strings.size()))).first;
+    strings.push_back(&it->first);
+  }
+  write_uint(it->second);
+}
+
+void BinaryWriter::write_string_id(int id) {
+  write_string(string_table->get(id));
+}
+
+void BinaryWriter::save(const char *filename) const {
+  // The string table is only complete now, but readers need it first.
+  BinaryWriter header(*string_table);
+  header.write_raw(SAS_BINARY_MAGIC, TAG_LENGTH);
+  unsigned int version = SAS_BINARY_VERSION;
+  for(int i = 0; i < 4; i++) {
+    header.body.push_back(version & 0xff);
+    version >>= 8;
+  }
+  header.begin_section("STRS");
+  header.write_uint(strings.size());
+  for(int i = 0; i < strings.size(); i++) {
+    header.write_uint(strings[i]->size());
+    header.write_raw(strings[i]->data(), strings[i]->size());
+  }
+  header.end_section();
+
+  ofstream outfile(filename, ios::out | ios::binary);
+  outfile.write(&header.body[0], header.body.size());
+  if(!body.empty())
+    outfile.write(&body[0], body.size());
+  outfile.close();
+  if(!outfile) {
+    cout << "Error writing " << filename << "." << endl;
+    exit(1);
+  }
+}
+
+BinaryReader::BinaryReader(const char *begin, const char *end_,
+			   StringTable &the_string_table)
+  : pos(reinterpret_cast<const unsigned char *>(begin)),
+    end(reinterpret_cast<const unsigned char *>(end_)),
+    section_end(end), string_table(&the_string_table) {
+  if(end - pos < TAG_LENGTH || memcmp(pos, SAS_BINARY_MAGIC, TAG_LENGTH) != 0)
+    fail("magic word");
+  pos += TAG_LENGTH;
+  unsigned long version = read_fixed(4);
+  if(version != SAS_BINARY_VERSION) {
+    cout << "Unsupported binary task version " << version
+	 << " (expected " << SAS_BINARY_VERSION << ")." << endl;
+    exit(1);
+  }
+  begin_section("STRS");
+  int count = read_count();
+  strings.resize(count);
+  for(int i = 0; i < count; i++) {
+    unsigned long length = read_uint();
+    if(length > section_end - pos)
+      fail("string");
+    strings[i].assign(reinterpret_cast<const char *>(pos), length);
+    pos += length;
+  }
+  end_section();
+  string_ids.resize(count, -1);
+}
+
+void BinaryReader::fail(const char *what) const {
+  cout << "Failed to read " << what << " from binary task." << endl;
+  exit(1);
+}
+
+unsigned long BinaryReader::read_fixed(int bytes) {
+  if(section_end - pos < bytes)
+    fail("fixed-width field");
+  unsigned long value = 0;
+  for(int i = 0; i < bytes; i++)
+    value |= (unsigned long) pos[i] << (8 * i);
+  pos += bytes;
+  return value;
+}
+
+void BinaryReader::begin_section(const char *tag) {
+  while(true) {
+    section_end = end;
+    if(end - pos < TAG_LENGTH + SECTION_LENGTH_BYTES) {
+      cout << "Missing section " << tag << " in binary task." << endl;
+      exit(1);
+    }
+    bool found = memcmp(pos, tag, TAG_LENGTH) == 0;
+    pos += TAG_LENGTH;
+    unsigned long length = read_fixed(SECTION_LENGTH_BYTES);
+    if(length > end - pos)
+      fail("section length");
+    if(found) {
+      section_end = pos + length;
+      return;
+    }
+    pos += length; // skip unknown section
+  }
+}
+
+void BinaryReader::end_section() {
+  // Skips fields appended by newer writers.
+  pos = section_end;
+  section_end = end;
+}
+
+unsigned long BinaryReader::read_uint() {
+  unsigned long value = 0;
+  int shift = 0;
+  while(true) {
+    if(pos == section_end || shift >= 64)
+      fail("integer");
+    unsigned char byte = *pos++;
+    value |= (unsigned long) (byte & 0x7f) << shift;
+    if(!(byte & 0x80))
+      return value;
+    shift += 7;
+  }
+}
+
+long BinaryReader::read_int() {
+  unsigned long bits = read_uint();
+  return (bits & 1) ? ~(bits >> 1) : (bits >> 1);
+}
+
+float BinaryReader::read_float() {
+  unsigned int bits = read_fixed(4);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+const string &BinaryReader::read_string() {
+  unsigned long id = read_uint();
+  if(id >= strings.size())
+    fail("string reference");
+  return strings[id];
+}
+
+int BinaryReader::read_string_id() {
+  unsigned long id = read_uint();
+  if(id >= strings.size())
+    fail("string reference");
+  if(string_ids[id] == -1)
+    string_ids[id] = string_table->intern(strings[id]);
+  return string_ids[id];
+}
+
+int BinaryReader::read_count() {
+  unsigned long count = read_uint();
+  if(count > section_end - pos)
+    fail("count");
+  return count;
+}
+
+Variable *BinaryReader::read_variable(const vector<Variable *> &variables) {
+  unsigned long var = read_uint();
+  if(var >= variables.size())
+    fail("variable number");
+  return variables[var];
+}
+
+bool is_binary_task(Tokenizer &in) {
+  return in.has_prefix(SAS_BINARY_MAGIC, TAG_LENGTH);
+}
+
+void read_binary_problem_description(PipelineContext &context,
+				     BinaryReader &in,
+				     string &name,
+				     string &metric,
+				     vector<Variable> &internal_variables,
+				     vector<Variable *> &variables,
+				     State &initial_state,
+				     vector<pair<Variable*, int> > &goals,
+				     OperatorTable &operators,
+				     vector<Axiom> &axioms,
+				     vector<Variable *> &shared_vars,
+				     vector<int> &shared_vars_number) {
+  in.begin_section("META");
+  name = in.read_string();
+  metric = in.read_string();
+  in.end_section();
+
+  in.begin_section("VARS");
+  int count = in.read_count();
+  internal_variables.reserve(count);
+  for(int i = 0; i < count; i++) {
+    internal_variables.push_back(Variable(in, i));
+    variables.push_back(&internal_variables.back());
+  }
+  in.end_section();
+
+  in.begin_section("INIT");
+  initial_state = State(in, variables);
+  in.end_section();
+
+  in.begin_section("SHRD");
+  count = in.read_count();
+  shared_vars.reserve(count);
+  for(int i = 0; i < count; i++) {
+    Variable *var = in.read_variable(variables);
+    shared_vars.push_back(var);
+    shared_vars_number.push_back(var->get_index());
+  }
+  in.end_section();
+
+  in.begin_section("GOAL");
+  count = in.read_count();
+  for(int i = 0; i < count; i++) {
+    Variable *var = in.read_variable(variables);
+    int val = in.read_int();
+    goals.push_back(make_pair(var, val));
+  }
+  in.end_section();
+
+  in.begin_section("OPER");
+  count = in.read_count();
+  operators.reserve(count);
+  for(int i = 0; i < count; i++)
+    operators.read_binary(in, variables);
+  in.end_section();
+
+  in.begin_section("AXIO");
+  count = in.read_count();
+  axioms.reserve(count);
+  for(int i = 0; i < count; i++)
+    axioms.push_back(Axiom(in, variables, context.get_task_arena()));
+  in.end_section();
+}
+
+void write_binary_problem_description(BinaryWriter &out,
+				      const string &name,
+				      const string &metric,
+				      const vector<Variable *> &variables,
+				      const State &initial_state,
+				      const vector<pair<Variable*, int> > &goals,
+				      const OperatorTable &operators,
+				      const vector<Axiom> &axioms,
+				      const vector<int> &shared_vars_number) {
+  out.begin_section("META");
+  out.write_string(name);
+  out.write_string(metric);
+  out.end_section();
+
+  out.begin_section("VARS");
+  out.write_uint(variables.size());
+  for(int i = 0; i < variables.size(); i++)
+    variables[i]->write_binary(out);
+  out.end_section();
+
+  out.begin_section("INIT");
+  initial_state.write_binary(out, variables);
+  out.end_section();
+
+  out.begin_section("SHRD");
+  out.write_uint(shared_vars_number.size());
+  for(int i = 0; i < shared_vars_number.size(); i++)
+    out.write_uint(shared_vars_number[i]);
+  out.end_section();
+
+  out.begin_section("GOAL");
+  out.write_uint(goals.size());
+  for(int i = 0; i < goals.size(); i++) {
+    out.write_uint(goals[i].first->get_index());
+    out.write_int(goals[i].second);
+  }
+  out.end_section();
+
+  out.begin_section("OPER");
+  out.write_uint(operators.size());
+  for(int i = 0; i < operators.size(); i++)
+    operators[i].write_binary(out);
+  out.end_section();
+
+  out.begin_section("AXIO");
+  out.write_uint(axioms.size());
+  for(int i = 0; i < axioms.size(); i++)
+    axioms[i].write_binary(out);
+  out.end_section();
+}
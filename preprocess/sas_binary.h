@@ -0,0 +1,147 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+#ifndef SAS_BINARY_H
+#define SAS_BINARY_H
+
+/*
+  Binary encoding of the translator output (output.sas).
+
+  Layout, version 1:
+
+    "SASB"                  magic
+    u32                     format version (little endian)
+    section*                each: 4-byte tag, u64 payload length
+                            (little endian), payload
+
+  The sections appear in this order:
+
+    STRS  string table: count, then (length, bytes) per string
+    META  agent name, metric
+    VARS  count, then per variable: name, range, layer, is_total_time
+    INIT  per variable: value, plus a float if the value is -1
+    SHRD  count, then the variable number of each shared variable
+    GOAL  count, then (variable, value) pairs
+    OPER  count, then the operators (see Operator::write_binary)
+    AXIO  count, then the axioms (see Axiom::write_binary)
+
+  Integers are varints (7 bits per byte, low bits first); signed
+  integers are zigzag-encoded first. Floats are IEEE 754 single
+  precision, little endian. Strings are varint indices into the
+  string table. A reader skips sections with unknown tags and any
+  trailing bytes of known sections, so fields can be appended without
+  breaking older readers.
+*/
+
+#include <map>
+#include <string>
+#include <vector>
+using namespace std;
+
+class Axiom;
+class OperatorTable;
+class PipelineContext;
+class State;
+class StringTable;
+class Tokenizer;
+class Variable;
+
+class BinaryWriter {
+  const StringTable *string_table;
+  vector<char> body;
+  vector<const string *> strings;
+  map<string, int> string_ids;
+  size_t section_start;
+
+  void write_raw(const char *bytes, size_t length);
+public:
+  // String ids passed to write_string_id() refer to string_table.
+  explicit BinaryWriter(const StringTable &string_table);
+  void begin_section(const char *tag);
+  void end_section();
+
+  void write_uint(unsigned long value);
+  void write_int(long value);
+  void write_float(float value);
+  void write_bool(bool value) {write_uint(value);}
+  void write_string(const string &str);
+  void write_string_id(int id);
+
+  void save(const char *filename) const;
+};
+
+class BinaryReader {
+  const unsigned char *pos;
+  const unsigned char *end;
+  const unsigned char *section_end;
+  vector<string> strings;
+  StringTable *string_table;
+  vector<int> string_ids; // in string_table, -1 if not interned yet
+
+  void fail(const char *what) const;
+  unsigned long read_fixed(int bytes);
+public:
+  // read_string_id() interns the strings in string_table.
+  BinaryReader(const char *begin, const char *end, StringTable &string_table);
+  StringTable &get_string_table() const {return *string_table;}
+  void begin_section(const char *tag);
+  void end_section();
+
+  unsigned long read_uint();
+  long read_int();
+  float read_float();
+  bool read_bool() {return read_uint() != 0;}
+  const string &read_string();
+  int read_string_id();
+  // Counts of items that take at least one byte each, so a count
+  // larger than the rest of the section fails before anything is
+  // allocated for it.
+  int read_count();
+  Variable *read_variable(const vector<Variable *> &variables);
+};
+
+extern const char *const SAS_BINARY_MAGIC;
+extern const unsigned int SAS_BINARY_VERSION;
+
+bool is_binary_task(Tokenizer &in);
+
+void read_binary_problem_description(PipelineContext &context,
+				     BinaryReader &in,
+				     string &name,
+				     string &metric,
+				     vector<Variable> &internal_variables,
+				     vector<Variable *> &variables,
+				     State &initial_state,
+				     vector<pair<Variable*, int> > &goals,
+				     OperatorTable &operators,
+				     vector<Axiom> &axioms,
+				     vector<Variable *> &shared_vars,
+				     vector<int> &shared_vars_number);
+
+void write_binary_problem_description(BinaryWriter &out,
+				      const string &name,
+				      const string &metric,
+				      const vector<Variable *> &variables,
+				      const State &initial_state,
+				      const vector<pair<Variable*, int> > &goals,
+				      const OperatorTable &operators,
+				      const vector<Axiom> &axioms,
+				      const vector<int> &shared_vars_number);
+
+#endif
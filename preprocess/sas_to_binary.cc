@@ -0,0 +1,67 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+/* Converts a translator output file (output.sas) to the binary task
+ * format described in "sas_binary.h", which preprocess reads directly.
+ */
+
+#include "helper_functions.h"
+#include "pipeline_context.h"
+#include "sas_binary.h"
+#include "state.h"
+#include "operator.h"
+#include "axiom.h"
+#include "variable.h"
+#include "tokenizer.h"
+#include <iostream>
+using namespace std;
+
+int main(int argc, const char **argv) {
+  if(argc != 3) {
+    cout << "usage: " << argv[0] << " <output.sas | - > <binary output>"
+	 << endl;
+    return 1;
+  }
+  PipelineContext context;
+  string name;
+  string metric;
+  vector<Variable *> variables;
+  vector<Variable> internal_variables;
+  State initial_state;
+  vector<pair<Variable *, int> > goals;
+  OperatorTable operators(context.get_strings(), context.get_conditions());
+  vector<Axiom> axioms;
+  vector<Variable *> shared_vars;
+  vector<int> shared_vars_number;
+
+  Tokenizer in(argv[1]);
+  name = in.read_string();
+  read_preprocessed_problem_description
+    (context, in, metric, internal_variables, variables, initial_state,
+     goals, operators, axioms, shared_vars, shared_vars_number);
+
+  BinaryWriter out(context.get_strings());
+  write_binary_problem_description
+    (out, name, metric, variables, initial_state, goals, operators, axioms,
+     shared_vars_number);
+  out.save(argv[2]);
+  cout << "Wrote " << variables.size() << " variables, "
+       << operators.size() << " operators and " << axioms.size()
+       << " axioms to " << argv[2] << "." << endl;
+}
@@ -25,74 +25,109 @@
 #include <vector>
 using namespace std;
 
-vector<vector<int> > SCC::get_result() {
+template<class Index>
+void SCC<Index>::get_result(const CompactGraph<Index> &the_graph,
+			    vector<int> &the_vertices,
+			    vector<int> &the_offsets) {
+  graph = &the_graph;
+  vertices = &the_vertices;
+  offsets = &the_offsets;
   // Get node count
-  int node_count = graph.size();
-  // initialise vector<int>, first three indexed by vertex number
-  dfs_numbers.resize(node_count, -1);
-  dfs_minima.resize(node_count, -1);
-  stack_indices.resize(node_count, -1);
-  // vector<int> This is indexed by the level of recursion.
+  int node_count = graph->get_node_count();
+  VertexInfo unvisited = {-1, -1, -1};
+  info.assign(node_count, unvisited);
+  stack.clear();
   stack.reserve(node_count);
+  frames.clear();
   current_dfs_number = 0;
+  // The components are found in reverse topological order, so they are
+  // stored from the back.
+  vertices->resize(node_count);
+  offsets->clear();
+  offsets->push_back(node_count);
+  unassigned = node_count;
 
   // For each node
   for(int i = 0; i < node_count; i++)
-    if(dfs_numbers[i] == -1)
+    if(info[i].dfs_number == -1)
       dfs(i);
 
-  reverse(sccs.begin(), sccs.end());
-  return sccs;
+  reverse(offsets->begin(), offsets->end());
 }
 
-void SCC::dfs(int vertex) {
+template<class Index>
+void SCC<Index>::visit(int vertex) {
   // current_dfs_number: global variable that indicates current depth
-  int vertex_dfs_number = current_dfs_number++;
-  dfs_numbers[vertex] = dfs_minima[vertex] = vertex_dfs_number;
+  VertexInfo &vertex_info = info[vertex];
+  vertex_info.dfs_number = vertex_info.dfs_minimum = current_dfs_number++;
   // stack is an stack of vertex that leads to this vertex
-  stack_indices[vertex] = stack.size();
+  vertex_info.stack_index = stack.size();
   stack.push_back(vertex);
+  frames.push_back(make_pair(vertex, graph->begin(vertex)));
+}
 
-  // For each successor of the vertex
-  const vector<int> &successors = graph[vertex];
-  for(int i = 0; i < successors.size(); i++) {
-	 // get index and dfs_number of the successor
-    int succ = successors[i];
-    int succ_dfs_number = dfs_numbers[succ];
-    // If the succ has not been analyzed yet
-    if(succ_dfs_number == -1) {
-      // Analyze
-      dfs(succ);
-      // The minimum dfs is the min value between the current min and the dfs of the successor
-      dfs_minima[vertex] = min(dfs_minima[vertex], dfs_minima[succ]);
-    }
-    // If the succ has been analyzed, the depth of the successor is minor than current and
-    // the successor can be found in the satack of the current vertex
-    else if(succ_dfs_number < vertex_dfs_number && stack_indices[succ] != -1) {
-      // Set the minimum dfs
-      dfs_minima[vertex] = min(dfs_minima[vertex], succ_dfs_number);
-    }
-  }
-
+template<class Index>
+void SCC<Index>::finish(int vertex) {
   // If the minimum dfs for the current vertex is the current one after analyzing all successors
-  if(dfs_minima[vertex] == vertex_dfs_number) {
-	 // Get stack index
-    int stack_index = stack_indices[vertex];
-     //Create scc: a stack of strongly connected components following the minimum stack
-    vector<int> scc;
+  const VertexInfo &vertex_info = info[vertex];
+  if(vertex_info.dfs_minimum == vertex_info.dfs_number) {
+    // Get stack index
+    int stack_index = vertex_info.stack_index;
+    //Create scc: the part of the stack above the current vertex
+    int size = stack.size() - stack_index;
+    unassigned -= size;
     for(int i = stack_index; i < stack.size(); i++) {
       // Add the component
-      scc.push_back(stack[i]);
+      (*vertices)[unassigned + i - stack_index] = stack[i];
       // Remove the index and set to default
-      stack_indices[stack[i]] = -1;
+      info[stack[i]].stack_index = -1;
     }
     // Erase the stack
     stack.erase(stack.begin() + stack_index, stack.end());
     // Add the scc to the list of sccs
-    sccs.push_back(scc);
+    offsets->push_back(unassigned);
   }
 }
 
+template<class Index>
+void SCC<Index>::dfs(int root) {
+  visit(root);
+  while(!frames.empty()) {
+    int vertex = frames.back().first;
+    int arc = frames.back().second;
+    if(arc < graph->end(vertex)) {
+      frames.back().second++;
+      // get index and dfs_number of the successor
+      int succ = graph->get_target(arc);
+      int succ_dfs_number = info[succ].dfs_number;
+      // If the succ has not been analyzed yet
+      if(succ_dfs_number == -1) {
+	// Analyze; the minimum is updated when it is finished
+	visit(succ);
+      }
+      // If the succ has been analyzed, the depth of the successor is minor than current and
+      // the successor can be found in the satack of the current vertex
+      else if(succ_dfs_number < info[vertex].dfs_number &&
+	      info[succ].stack_index != -1) {
+	// Set the minimum dfs
+	info[vertex].dfs_minimum = min(info[vertex].dfs_minimum, succ_dfs_number);
+      }
+    } else {
+      frames.pop_back();
+      finish(vertex);
+      if(!frames.empty()) {
+	// The minimum dfs is the min value between the current min and the dfs of the successor
+	VertexInfo &parent_info = info[frames.back().first];
+	parent_info.dfs_minimum = min(parent_info.dfs_minimum,
+				      info[vertex].dfs_minimum);
+      }
+    }
+  }
+}
+
+template class SCC<unsigned short>;
+template class SCC<unsigned int>;
+
 /*
 #include <iostream>
 using namespace std;
@@ -119,18 +154,18 @@ int main() {
   int n8[] = {1, -1};
   int *all_nodes[] = {n0, n1, n2, n3, n4, n5, n6, n7, n8, 0};
 
-  vector<vector<int> > graph;
+  CompactGraph<unsigned short> graph;
   for(int i = 0; all_nodes[i] != 0; i++) {
-    vector<int> successors;
     for(int j = 0; all_nodes[i][j] != -1; j++)
-      successors.push_back(all_nodes[i][j]);
-    graph.push_back(successors);
+      graph.add_arc(all_nodes[i][j]);
+    graph.finish_node();
   }
 
-  vector<vector<int> > sccs = SCC(graph).get_result();
-  for(int i = 0; i < sccs.size(); i++) {
-    for(int j = 0; j < sccs[i].size(); j++)
-      cout << " " << sccs[i][j];
+  vector<int> vertices, offsets;
+  SCC<unsigned short>().get_result(graph, vertices, offsets);
+  for(int i = 0; i + 1 < offsets.size(); i++) {
+    for(int j = offsets[i]; j < offsets[i + 1]; j++)
+      cout << " " << vertices[j];
     cout << endl;
   }
 }
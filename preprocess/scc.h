@@ -28,37 +28,52 @@
   strongly connected components. It takes time proportional to the sum
   of the number of vertices and arcs.
 
-  Instantiate class SCC with a graph represented as a vector of vectors,
-  where graph[i] is the vector of successors of vertex i.
+  Method get_result() partitions the vertices of a CompactGraph into
+  strongly connected components. Each SCC is a maximal subset such
+  that each node in an SCC is reachable from all other nodes in the
+  SCC. Note that the derived graph where each SCC is a single
+  "supernode" is necessarily acyclic. The SCCs are returned in a
+  topological sort order with regard to this derived DAG, flattened
+  like a CSR graph: component i consists of the vertices
+  vertices[offsets[i]] .. vertices[offsets[i + 1] - 1].
 
-  Method get_result() returns a vector of strongly connected components,
-  each of which is a vector of vertices (ints).
-  This is a partitioning of all vertices where each SCC is a maximal subset
-  such that each node in an SCC is reachable from all other nodes in the SCC.
-  Note that the derived graph where each SCC is a single "supernode" is
-  necessarily acyclic. The SCCs returned by get_result() are in a topological
-  sort order with regard to this derived DAG.
+  An SCC object keeps its working arrays between calls, so checking
+  many graphs with the same object does not allocate.
 */
 
+#include "compact_graph.h"
+
 #include <vector>
 using namespace std;
 
+template<class Index>
 class SCC {
-  const vector<vector<int> > &graph;
+  const CompactGraph<Index> *graph;
 
-  // The following three are indexed by vertex number.
-  vector<int> dfs_numbers;
-  vector<int> dfs_minima;
-  vector<int> stack_indices;
+  struct VertexInfo {
+    int dfs_number;  // -1 if not visited yet
+    int dfs_minimum;
+    int stack_index; // -1 if not on the stack
+  };
+  vector<VertexInfo> info; // indexed by vertex number
 
-  vector<int> stack; // This is indexed by the level of recursion.
-  vector<vector<int> > sccs;
+  // The depth-first search keeps its path in frames instead of on the
+  // call stack, so long paths cannot overflow it: each frame is a
+  // vertex and the next of its arcs to follow.
+  vector<pair<int, int> > frames;
+  vector<int> stack; // vertices of the components not yet complete
+  vector<int> *vertices;
+  vector<int> *offsets;
+  int unassigned; // vertices[0 .. unassigned - 1] are still free
 
   int current_dfs_number;
 
+  void visit(int vertex);
+  void finish(int vertex);
   void dfs(int vertex);
 public:
-  SCC(const vector<vector<int> > &theGraph) : graph(theGraph) {}
-  vector<vector<int> > get_result();
+  SCC() : graph(0), vertices(0), offsets(0) {}
+  void get_result(const CompactGraph<Index> &graph,
+		  vector<int> &vertices, vector<int> &offsets);
 };
 #endif
@@ -0,0 +1,50 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+#ifndef SPAN_H
+#define SPAN_H
+
+#include <vector>
+using namespace std;
+
+// Read-only view of a contiguous range of elements owned by someone
+// else, e.g. the entries of one operator in a flat table.
+template<class T>
+class Span {
+  const T *first;
+  const T *last;
+public:
+  Span() : first(0), last(0) {}
+  Span(const T *begin, const T *end) : first(begin), last(end) {}
+  int size() const {return last - first;}
+  bool empty() const {return first == last;}
+  const T &operator[](int i) const {return first[i];}
+  const T *begin() const {return first;}
+  const T *end() const {return last;}
+};
+
+// Elements begin .. end - 1 of vec; only valid until vec is resized.
+template<class T>
+Span<T> make_span(const vector<T> &vec, int begin, int end) {
+  if(begin == end)
+    return Span<T>();
+  return Span<T>(&vec[0] + begin, &vec[0] + end);
+}
+
+#endif
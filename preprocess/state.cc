@@ -22,40 +22,51 @@
 
 #include "state.h"
 #include "helper_functions.h"
+#include "tokenizer.h"
+#include "sas_binary.h"
+#include "variable.h"
 #include "float.h"
 
-class Variable;
-
-State::State(istream &in, const vector<Variable *> &variables) {
-  check_magic(in, "begin_state");
+State::State(Tokenizer &in, const vector<Variable *> &variables)
+  : values(variables.size()), numeric_values(variables.size(), FLT_MAX) {
+  in.check_magic("begin_state");
   for(int i = 0; i < variables.size(); i++) {
-    int value;
-    float num_value;
-    in >> value; //for axioms, this is default value
+    int value = in.read_int(); //for axioms, this is default value
+    values[i] = value;
+    if(value == -1)
+      numeric_values[i] = in.read_float();
+  }
+  in.check_magic("end_state");
+}
 
+State::State(BinaryReader &in, const vector<Variable *> &variables)
+  : values(variables.size()), numeric_values(variables.size(), FLT_MAX) {
+  for(int i = 0; i < variables.size(); i++) {
+    int value = in.read_int();
+    values[i] = value;
     if(value == -1)
-    {
-        values[variables[i]] = value;
-    	in >> num_value;
-    	numeric_values[variables[i]] = num_value;
-    }else{
-    	numeric_values[variables[i]] = FLT_MAX;
-    	values[variables[i]] = value;
-    }
+      numeric_values[i] = in.read_float();
+  }
 }
-  check_magic(in, "end_state");
+
+void State::write_binary(BinaryWriter &out,
+			 const vector<Variable *> &variables) const {
+  for(int i = 0; i < variables.size(); i++) {
+    out.write_int(values[i]);
+    if(values[i] == -1)
+      out.write_float(numeric_values[i]);
+  }
 }
 
-int State::operator[](Variable *var) const {
-  return values.find(var)->second;
+int State::operator[](const Variable *var) const {
+  return values[var->get_index()];
 }
 
-float State::get_numeric_value(Variable *var) const {
-	return numeric_values.find(var)->second;
+float State::get_numeric_value(const Variable *var) const {
+  return numeric_values[var->get_index()];
 }
 
-void State::dump() const {
-  for(map<Variable *, int>::const_iterator it = values.begin();
-      it != values.end(); ++it)
-    cout << "  " << it->first->get_name() << ": " << it->second << endl;
+void State::dump(const vector<Variable *> &variables) const {
+  for(int i = 0; i < variables.size(); i++)
+    cout << "  " << variables[i]->get_name() << ": " << values[i] << endl;
 }
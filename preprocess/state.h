@@ -24,22 +24,29 @@
 #define STATE_H
 
 #include <iostream>
-#include <map>
 #include <vector>
 using namespace std;
 
+class BinaryReader;
+class BinaryWriter;
+class Tokenizer;
 class Variable;
 
+// Values are indexed by Variable::get_index(). The numeric value of a
+// variable is only meaningful if its value is -1; it is FLT_MAX otherwise.
 class State {
-  map<Variable *, int> values;
-  map<Variable *, float> numeric_values;
+  vector<int> values;
+  vector<float> numeric_values;
   public:
   State() {}
-  State(istream &in, const vector<Variable *> &variables);
+  State(Tokenizer &in, const vector<Variable *> &variables);
+  State(BinaryReader &in, const vector<Variable *> &variables);
+  void write_binary(BinaryWriter &out,
+		    const vector<Variable *> &variables) const;
 
-  int operator[](Variable *var) const;
-  float get_numeric_value(Variable *var) const;
-  void dump() const;
+  int operator[](const Variable *var) const;
+  float get_numeric_value(const Variable *var) const;
+  void dump(const vector<Variable *> &variables) const;
 };
 
 #endif
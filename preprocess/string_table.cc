@@ -0,0 +1,141 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+#include "string_table.h"
+
+#include <cstdlib>
+#include <cstring>
+using namespace std;
+
+static const size_t BLOCK_SIZE = 1 << 16;
+
+// FNV-1a
+static size_t hash_string(const char *str, size_t length) {
+  size_t hash = 2166136261u;
+  for(size_t i = 0; i < length; i++) {
+    hash ^= (unsigned char) str[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+class MutexLock {
+  pthread_mutex_t &mutex;
+public:
+  MutexLock(pthread_mutex_t &m) : mutex(m) {pthread_mutex_lock(&mutex);}
+  ~MutexLock() {pthread_mutex_unlock(&mutex);}
+};
+
+StringTable::StringTable() : block_free(0), total_chars(0) {
+  pthread_mutex_init(&mutex, 0);
+  buckets.resize(1024, -1);
+  intern("", 0);
+}
+
+StringTable::~StringTable() {
+  for(int i = 0; i < blocks.size(); i++)
+    free(blocks[i]);
+  pthread_mutex_destroy(&mutex);
+}
+
+const char *StringTable::store(const char *str, size_t length) {
+  if(length == 0)
+    return "";
+  if(length > block_free) {
+    // Long strings get a block of their own.
+    size_t size = length > BLOCK_SIZE / 4 ? length : BLOCK_SIZE;
+    char *block = static_cast<char *>(malloc(size));
+    if(size == length) {
+      blocks.insert(blocks.end() - (blocks.empty() ? 0 : 1), block);
+      memcpy(block, str, length);
+      return block;
+    }
+    blocks.push_back(block);
+    block_free = size;
+  }
+  char *data = blocks.back() + (BLOCK_SIZE - block_free);
+  memcpy(data, str, length);
+  block_free -= length;
+  return data;
+}
+
+void StringTable::grow_buckets() {
+  buckets.assign(buckets.size() * 2, -1);
+  size_t mask = buckets.size() - 1;
+  for(int id = 0; id < entries.size(); id++) {
+    size_t bucket = entries[id].hash & mask;
+    while(buckets[bucket] != -1)
+      bucket = (bucket + 1) & mask;
+    buckets[bucket] = id;
+  }
+}
+
+int StringTable::intern(const char *str, size_t length) {
+  MutexLock lock(mutex);
+  size_t hash = hash_string(str, length);
+  size_t mask = buckets.size() - 1;
+  size_t bucket = hash & mask;
+  while(buckets[bucket] != -1) {
+    const Entry &entry = entries[buckets[bucket]];
+    if(entry.hash == hash && entry.length == length &&
+       memcmp(entry.data, str, length) == 0)
+      return buckets[bucket];
+    bucket = (bucket + 1) & mask;
+  }
+  Entry entry;
+  entry.data = store(str, length);
+  entry.length = length;
+  entry.hash = hash;
+  int id = entries.size();
+  entries.push_back(entry);
+  buckets[bucket] = id;
+  total_chars += length;
+  if(entries.size() * 2 > buckets.size())
+    grow_buckets();
+  return id;
+}
+
+string StringTable::get(int id) const {
+  MutexLock lock(mutex);
+  const Entry &entry = entries[id];
+  return string(entry.data, entry.length);
+}
+
+void StringTable::get(int id, const char *&data, size_t &length) const {
+  MutexLock lock(mutex);
+  data = entries[id].data;
+  length = entries[id].length;
+}
+
+void StringTable::write(ostream &out, int id) const {
+  const char *data;
+  size_t length;
+  get(id, data, length);
+  out.write(data, length);
+}
+
+int StringTable::size() const {
+  MutexLock lock(mutex);
+  return entries.size();
+}
+
+size_t StringTable::get_total_chars() const {
+  MutexLock lock(mutex);
+  return total_chars;
+}
@@ -0,0 +1,74 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+#ifndef STRING_TABLE_H
+#define STRING_TABLE_H
+
+/*
+  Table of interned strings; each PipelineContext has one.
+
+  Names of variables and operators and runtime cost expressions are
+  stored once and referred to by their id, so copying an operator
+  copies a few integers. The text is only materialized when it is
+  written out. Id 0 is always the empty string.
+
+  The characters live in fixed-size blocks that never move. All
+  methods lock, so the table can be used from the parser threads.
+*/
+
+#include <pthread.h>
+
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+class StringTable {
+  struct Entry {
+    const char *data;
+    size_t length;
+    size_t hash;
+  };
+  vector<Entry> entries;   // indexed by id
+  vector<int> buckets;     // open addressing; -1 is empty
+  vector<char *> blocks;
+  size_t block_free;
+  size_t total_chars;
+  mutable pthread_mutex_t mutex;
+
+  const char *store(const char *str, size_t length);
+  void grow_buckets();
+
+  StringTable(const StringTable &copy);
+  StringTable &operator=(const StringTable &copy);
+public:
+  StringTable();
+  ~StringTable();
+
+  int intern(const char *str, size_t length);
+  int intern(const string &str) {return intern(str.data(), str.size());}
+  string get(int id) const;
+  // The characters, without a terminating null, stay where they are.
+  void get(int id, const char *&data, size_t &length) const;
+  void write(ostream &out, int id) const;
+  int size() const;
+  size_t get_total_chars() const;
+};
+
+#endif
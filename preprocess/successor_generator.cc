@@ -20,7 +20,10 @@
  *
  *********************************************************************/
 
+#include "arena.h"
+#include "condition_table.h"
 #include "operator.h"
+#include "pipeline_context.h"
 #include "successor_generator.h"
 #include "variable.h"
 
@@ -33,78 +36,135 @@
 
 using namespace std;
 
-/* NOTE on possible optimizations:
+/* NOTE on the construction:
 
-   * Sharing "GeneratorEmpty" instances might help quite a bit with
-     reducing memory usage and possibly even speed, because there are
-     bound to be many instance of those. However, it complicates
-     deleting the successor generator, and memory doesn't seem to be
-     an issue. Speed appears to be fine now, too. So this is probably
-     an unnecessary complication.
+   * All empty subtrees share one "GeneratorEmpty" instance. This is
+     possible because the nodes are never deleted on their own. No other
+     subtrees can be shared: every operator is in exactly one node.
+     Empty children are therefore the bulk of the output; the runs and
+     sparse encodings (see successor_generator.h) leave most of them out.
 
-   * Using slist instead of list led to a further 10% speedup on the
-     largest Logistics instance, logistics-98/prob28.pddl. It would of
-     course also reduce memory usage. However, it would make the code
-     g++-specific, so it's probably not worth it.
+   * The operator indices are kept in a single vector, and every subtree
+     being built owns a range of it. A switch partitions its range into
+     the ranges of its children with a stable counting sort, so no lists
+     are allocated and the operators keep their order.
 
 */
 
+// Size of the tree as written (shared empty nodes are counted once per
+// reference) and how many nodes and operators a lookup visits.
+struct GeneratorStatistics {
+  int switches;
+  int leaves;
+  int empty_nodes;
+  int operator_entries;
+};
+
+// Nodes live in the graph arena and are never deleted on their own.
 class GeneratorBase {
 public:
   virtual ~GeneratorBase() {}
+  virtual bool is_empty() const {return false;}
+  // Adds the subtree to the statistics and returns the expected number
+  // of nodes and operators a lookup visits in it, if the values of all
+  // variables are uniformly distributed.
+  virtual double collect_statistics(GeneratorStatistics &statistics) const = 0;
   virtual void dump(string indent) const = 0;
-  virtual void generate_cpp_input(ofstream &outfile) const = 0;
+  // Appends the non-empty operator lists of the subtree in the order in
+  // which they are written.
+  virtual void append_operator_lists(vector<Span<int> > &lists) const = 0;
+  virtual void generate_cpp_input(ofstream &outfile,
+				  const PipelineContext &context) const = 0;
 };
 
 class GeneratorSwitch : public GeneratorBase {
   Variable *switch_var;
-  list<int> immediate_ops_indices;
-  vector<GeneratorBase *> generator_for_value;
+  int switch_level;
+  Span<int> immediate_ops_indices;
+  // One child per value of switch_var; the children are filled in by
+  // the construction after the node has been created.
+  GeneratorBase **generator_for_value;
   GeneratorBase *default_generator;
+
+  enum ChildList {DENSE_LIST, SPARSE_LIST, BITMAP_LIST};
+  unsigned long get_bitmap_word(int word) const;
+  ChildList choose_child_list(int &children) const;
 public:
-  ~GeneratorSwitch();
-  GeneratorSwitch(Variable *switch_variable,
-		  list<int> &operators,
-		  const vector<GeneratorBase *> &gen_for_val,
-		  GeneratorBase *default_gen);
+  GeneratorSwitch(Arena &arena, Variable *switch_variable,
+		  int switch_variable_level, Span<int> operators);
+  GeneratorBase **get_child_slot(int value) {
+    return &generator_for_value[value];
+  }
+  GeneratorBase **get_default_slot() {
+    return &default_generator;
+  }
+  virtual double collect_statistics(GeneratorStatistics &statistics) const;
   virtual void dump(string indent) const;
-  virtual void generate_cpp_input(ofstream &outfile) const;
+  virtual void append_operator_lists(vector<Span<int> > &lists) const;
+  virtual void generate_cpp_input(ofstream &outfile,
+				  const PipelineContext &context) const;
 };
 
 class GeneratorLeaf : public GeneratorBase {
-  list<int> applicable_ops_indices;
+  Span<int> applicable_ops_indices;
 public:
-  GeneratorLeaf(list<int> &operators);
+  GeneratorLeaf(Span<int> operators);
+  virtual double collect_statistics(GeneratorStatistics &statistics) const;
   virtual void dump(string indent) const;
-  virtual void generate_cpp_input(ofstream &outfile) const;
+  virtual void append_operator_lists(vector<Span<int> > &lists) const;
+  virtual void generate_cpp_input(ofstream &outfile,
+				  const PipelineContext &context) const;
 };
 
 class GeneratorEmpty : public GeneratorBase {
 public:
+  virtual bool is_empty() const {return true;}
+  virtual double collect_statistics(GeneratorStatistics &statistics) const;
   virtual void dump(string indent) const;
-  virtual void generate_cpp_input(ofstream &outfile) const;
+  virtual void append_operator_lists(vector<Span<int> > &lists) const;
+  virtual void generate_cpp_input(ofstream &outfile,
+				  const PipelineContext &context) const;
 };
 
-GeneratorSwitch::GeneratorSwitch(Variable *switch_variable, 
-				 list<int> &operators,
-				 const vector<GeneratorBase *> &gen_for_val,
-				 GeneratorBase *default_gen)
-  : switch_var(switch_variable),
-    generator_for_value(gen_for_val),
-    default_generator(default_gen) {
-  immediate_ops_indices.swap(operators);
+// Copies op_indices[begin .. end - 1] into the arena.
+static Span<int> copy_operators(Arena &arena, const vector<int> &op_indices,
+				int begin, int end) {
+  if(begin == end)
+    return Span<int>();
+  int *data = arena.allocate_array<int>(end - begin);
+  copy(op_indices.begin() + begin, op_indices.begin() + end, data);
+  return Span<int>(data, data + (end - begin));
 }
 
-GeneratorSwitch::~GeneratorSwitch() {
-  for(int i = 0; i < generator_for_value.size(); i++)
-    delete generator_for_value[i];
-  delete default_generator;
+GeneratorSwitch::GeneratorSwitch(Arena &arena, Variable *switch_variable,
+				 int switch_variable_level,
+				 Span<int> operators)
+  : switch_var(switch_variable), switch_level(switch_variable_level),
+    immediate_ops_indices(operators),
+    generator_for_value(arena.allocate_array<GeneratorBase *>
+			(switch_variable->get_range())),
+    default_generator(0) {
+  for(int i = 0; i < switch_var->get_range(); i++)
+    generator_for_value[i] = 0;
+}
+
+double GeneratorSwitch::collect_statistics(
+  GeneratorStatistics &statistics) const {
+  statistics.switches++;
+  statistics.operator_entries += immediate_ops_indices.size();
+  int range = switch_var->get_range();
+  double children_cost = 0;
+  for(int i = 0; i < range; i++)
+    children_cost += generator_for_value[i]->collect_statistics(statistics);
+  // A lookup visits the child of one value and the default child.
+  return 1 + immediate_ops_indices.size() + children_cost / range +
+    default_generator->collect_statistics(statistics);
 }
 
 void GeneratorSwitch::dump(string indent) const {
   cout << indent << "switch on " << switch_var->get_name() << endl;
   cout << indent << "immediately:" << endl;
-  for(list<int>::const_iterator op_iter = immediate_ops_indices.begin();
+  for(const int *op_iter = immediate_ops_indices.begin();
       op_iter != immediate_ops_indices.end(); ++op_iter)
     cout << indent << *op_iter << endl;
   for(int i = 0; i < switch_var->get_range(); i++) {
@@ -115,176 +175,475 @@ void GeneratorSwitch::dump(string indent) const {
   default_generator->dump(indent + "  ");
 }
 
-void GeneratorSwitch::generate_cpp_input(ofstream &outfile) const {
-  int level = switch_var->get_level();
-  assert(level != -1);
-  outfile << "switch " << level << endl;
-  outfile << "check " << immediate_ops_indices.size() << endl;
-  for(list<int>::const_iterator op_iter = immediate_ops_indices.begin();
-      op_iter != immediate_ops_indices.end(); ++op_iter)
-    outfile << *op_iter << endl;
+// In the runs encoding, consecutive empty children of a switch are
+// written as one line "empty <count>" instead of one "check 0" each.
+static void write_empty_run(ofstream &outfile, int &empty_run) {
+  if(empty_run) {
+    outfile << "empty " << empty_run << endl;
+    empty_run = 0;
+  }
+}
+
+static void write_child(ofstream &outfile, const GeneratorBase *child,
+			const PipelineContext &context, int &empty_run) {
+  if(context.get_successor_generator_encoding() == SG_ENCODING_EMPTY_RUNS &&
+     child->is_empty()) {
+    empty_run++;
+  } else {
+    write_empty_run(outfile, empty_run);
+    child->generate_cpp_input(outfile, context);
+  }
+}
+
+// Writes "check <count>" and the operators, or "range <first> <count>"
+// for consecutive operators if PipelineContext::get_operator_ranges().
+static void write_operators(ofstream &outfile, Span<int> operators,
+			    const PipelineContext &context) {
+  bool is_range = context.get_operator_ranges() && !operators.empty();
+  for(int i = 1; is_range && i < operators.size(); i++)
+    is_range = operators[i] == operators[0] + i;
+  if(is_range) {
+    outfile << "range " << operators[0] << " " << operators.size() << endl;
+  } else {
+    outfile << "check " << operators.size() << endl;
+    for(const int *op_iter = operators.begin();
+	op_iter != operators.end(); ++op_iter)
+      outfile << *op_iter << endl;
+  }
+}
+
+static int decimal_length(unsigned long number) {
+  int length = 1;
+  while(number >= 10) {
+    number /= 10;
+    length++;
+  }
+  return length;
+}
+
+// Bits 0 .. 31 of the word tell which of the children of values
+// 32 * word .. 32 * word + 31 are not empty.
+unsigned long GeneratorSwitch::get_bitmap_word(int word) const {
+  int range = switch_var->get_range();
+  unsigned long bits = 0;
+  for(int i = 32 * word; i < range && i < 32 * (word + 1); i++)
+    if(!generator_for_value[i]->is_empty())
+      bits |= 1UL << (i % 32);
+  return bits;
+}
+
+// Picks the child list of the sparse encoding that takes the fewest
+// bytes, and counts the non-empty children.
+GeneratorSwitch::ChildList GeneratorSwitch::choose_child_list(
+  int &children) const {
+  int range = switch_var->get_range();
+  int words = (range + 31) / 32;
+  children = 0;
+  int sparse_values_size = 0;
+  for(int i = 0; i < range; i++) {
+    if(!generator_for_value[i]->is_empty()) {
+      children++;
+      sparse_values_size += decimal_length(i) + 1;
+    }
+  }
+  int dense_size = 6 + (range - children) * 8; // "dense", "check 0"s
+  int sparse_size = 8 + decimal_length(children) + sparse_values_size;
+  int bitmap_size = 9 + decimal_length(children) + decimal_length(words);
+  for(int i = 0; i < words; i++)
+    bitmap_size += 1 + decimal_length(get_bitmap_word(i));
+  if(dense_size <= sparse_size && dense_size <= bitmap_size)
+    return DENSE_LIST;
+  else if(sparse_size <= bitmap_size)
+    return SPARSE_LIST;
+  else
+    return BITMAP_LIST;
+}
+
+void GeneratorSwitch::append_operator_lists(vector<Span<int> > &lists) const {
+  if(!immediate_ops_indices.empty())
+    lists.push_back(immediate_ops_indices);
+  for(int i = 0; i < switch_var->get_range(); i++)
+    generator_for_value[i]->append_operator_lists(lists);
+  default_generator->append_operator_lists(lists);
+}
+
+void GeneratorSwitch::generate_cpp_input(ofstream &outfile,
+					 const PipelineContext &context) const {
+  assert(switch_level != -1);
+  outfile << "switch " << switch_level << endl;
+  write_operators(outfile, immediate_ops_indices, context);
+  ChildList child_list = DENSE_LIST;
+  if(context.get_successor_generator_encoding() == SG_ENCODING_SPARSE) {
+    int children;
+    child_list = choose_child_list(children);
+    if(child_list == DENSE_LIST) {
+      outfile << "dense" << endl;
+    } else if(child_list == SPARSE_LIST) {
+      outfile << "sparse " << children << endl;
+    } else {
+      int words = (switch_var->get_range() + 31) / 32;
+      outfile << "bitmap " << children << " " << words;
+      for(int i = 0; i < words; i++)
+	outfile << " " << get_bitmap_word(i);
+      outfile << endl;
+    }
+  }
+  int empty_run = 0;
   for(int i = 0; i < switch_var->get_range(); i++) {
-    cout << "case "<<switch_var->get_name()<<" (Level " <<switch_var->get_level() <<
-      ") has value " << i << ":" << endl;
-    generator_for_value[i]->generate_cpp_input(outfile);
+    cout << "case ";
+    context.get_strings().write(cout, switch_var->get_name_id());
+    cout << " (Level " << switch_level << ") has value " << i << ":" << endl;
+    const GeneratorBase *child = generator_for_value[i];
+    if(child_list == DENSE_LIST) {
+      write_child(outfile, child, context, empty_run);
+    } else if(!child->is_empty()) {
+      if(child_list == SPARSE_LIST)
+	outfile << i << endl;
+      child->generate_cpp_input(outfile, context);
+    }
   }
   cout << "always:" << endl;
-  default_generator->generate_cpp_input(outfile);
+  write_child(outfile, default_generator, context, empty_run);
+  write_empty_run(outfile, empty_run);
 }
 
-GeneratorLeaf::GeneratorLeaf(list<int> &ops) {
-  applicable_ops_indices.swap(ops);
+GeneratorLeaf::GeneratorLeaf(Span<int> ops)
+  : applicable_ops_indices(ops) {
+}
+
+double GeneratorLeaf::collect_statistics(
+  GeneratorStatistics &statistics) const {
+  statistics.leaves++;
+  statistics.operator_entries += applicable_ops_indices.size();
+  return 1 + applicable_ops_indices.size();
 }
 
 void GeneratorLeaf::dump(string indent) const {
-  for(list<int>::const_iterator op_iter = applicable_ops_indices.begin();
+  for(const int *op_iter = applicable_ops_indices.begin();
       op_iter != applicable_ops_indices.end(); ++op_iter)
     cout << indent << *op_iter << endl;
 }
 
-void GeneratorLeaf::generate_cpp_input(ofstream &outfile) const {
-  outfile << "check " << applicable_ops_indices.size() << endl;
-  for(list<int>::const_iterator op_iter = applicable_ops_indices.begin();
-      op_iter != applicable_ops_indices.end(); ++op_iter)
-    outfile << *op_iter << endl;
+void GeneratorLeaf::append_operator_lists(vector<Span<int> > &lists) const {
+  lists.push_back(applicable_ops_indices);
+}
+
+void GeneratorLeaf::generate_cpp_input(ofstream &outfile,
+				       const PipelineContext &context) const {
+  write_operators(outfile, applicable_ops_indices, context);
+}
+
+double GeneratorEmpty::collect_statistics(
+  GeneratorStatistics &statistics) const {
+  statistics.empty_nodes++;
+  return 1;
 }
 
 void GeneratorEmpty::dump(string indent) const {
   cout << indent << "<empty>" << endl;
 }
 
-void GeneratorEmpty::generate_cpp_input(ofstream &outfile) const {
+void GeneratorEmpty::append_operator_lists(vector<Span<int> > &) const {
+}
+
+void GeneratorEmpty::generate_cpp_input(ofstream &outfile,
+					const PipelineContext &) const {
   outfile << "check 0" << endl;
 }
 
-SuccessorGenerator::SuccessorGenerator(const vector<Variable *> &variables,
-				       const vector<Operator> &operators) {
-  // We need the iterators to conditions to be stable:
+static bool has_smaller_index(const Variable *var, const Variable *other) {
+  return var->get_index() < other->get_index();
+}
+
+SuccessorGenerator::SuccessorGenerator(PipelineContext &the_context,
+				       const vector<Variable *> &variables,
+				       const OperatorTable &operators)
+  : context(&the_context) {
   conditions.reserve(operators.size());
-  list<int> all_operator_indices;
+  next_condition_by_op.reserve(operators.size());
+  op_indices.reserve(operators.size());
+  int max_condition_var = -1;
   // For each operator
   for(int i = 0; i < operators.size(); i++) {
-    const Operator *op = &operators[i];
-    Condition cond;
-    // For each prevail in the operator
-    for(int j = 0; j < op->get_prevail().size(); j++) {
-      Operator::Prevail prev = op->get_prevail()[j];
-      cond.push_back(make_pair(prev.var, prev.prev));
-    }
-    // For each effect, get also the pre to construct conditions
-    for(int j = 0; j < op->get_pre_post().size(); j++) {
-      Operator::PrePost pre_post = op->get_pre_post()[j];
-      if((pre_post.pre != -1) && ((pre_post.pre != -2) && (pre_post.pre != -3) && (pre_post.pre != -4) && (pre_post.pre != -5) && (pre_post.pre != -6)))
-	cond.push_back(make_pair(pre_post.var, pre_post.pre));
-    }
-    sort(cond.begin(), cond.end());
-    // We finally get several vectors: operator indices, conditions and
-    // vector of pointers (iterator) to each condition in the
-    // conditions vector indexed by operator index
-    all_operator_indices.push_back(i);
-    conditions.push_back(cond);
+    // The prevail conditions and preconditions of the operator are
+    // interned in the ConditionTable, sorted by variable. We get several
+    // vectors: operator indices, conditions and a pointer to the next
+    // condition of each operator, indexed by operator index
+    op_indices.push_back(i);
+    conditions.push_back(context->get_conditions().get(
+			   operators[i].get_precondition_id()));
     next_condition_by_op.push_back(conditions.back().begin());
+    if(!conditions.back().empty())
+      max_condition_var = max(max_condition_var,
+			      conditions.back().end()[-1].first);
   }
+  buckets.resize(operators.size());
+  partition_buffer.resize(operators.size());
   
   varOrder = variables;
-  sort(varOrder.begin(), varOrder.end());
+  sort(varOrder.begin(), varOrder.end(), has_smaller_index);
+  first_switch_at_least.resize(max_condition_var + 1);
+  int switch_var_no = 0;
+  for(int var = 0; var <= max_condition_var; var++) {
+    while(switch_var_no < varOrder.size() &&
+	  varOrder[switch_var_no]->get_index() < var)
+      switch_var_no++;
+    first_switch_at_least[var] = switch_var_no;
+  }
+
+  if(context->get_switch_order() == SWITCH_ORDER_COST) {
+    // Conditions on variables outside of varOrder can never be
+    // switched on; they are left to the search, as in index order.
+    condition_counts.assign(max_condition_var + 1, 0);
+    condition_starts.reserve(operators.size());
+    remaining_conditions.reserve(operators.size());
+    int fact_count = 0;
+    for(int i = 0; i < operators.size(); i++) {
+      int remaining = 0;
+      for(int j = 0; j < conditions[i].size(); j++) {
+	int var = conditions[i][j].first;
+	int pos = first_switch_at_least[var];
+	if(pos < varOrder.size() && varOrder[pos]->get_index() == var)
+	  remaining++;
+      }
+      condition_starts.push_back(fact_count);
+      remaining_conditions.push_back(remaining);
+      fact_count += conditions[i].size();
+    }
+    is_consumed.assign(fact_count, false);
+  }
 
-  root = construct_recursive(0, all_operator_indices);
+  // The tree is built top-down from an explicit stack of subtrees.
+  empty_generator = new(context->get_graph_arena()) GeneratorEmpty;
+  vector<ConstructionStep> steps;
+  int op_count = op_indices.size();
+  ConstructionStep root_step = {0, op_count, 0, &root};
+  steps.push_back(root_step);
+  while(!steps.empty()) {
+    ConstructionStep step = steps.back();
+    steps.pop_back();
+    *step.slot = construct_node(step, steps);
+  }
 }
 
-GeneratorBase *SuccessorGenerator::construct_recursive(int switch_var_no,
-						       list<int> &op_indices) {
-  if(op_indices.empty())
-    return new GeneratorEmpty;
+/*
+  The assign_buckets functions pick the variable to switch on for the
+  operators of a step and sort each operator into a bucket: 0 for the
+  operators without further conditions (applicable), 1 + value for those
+  that require a value of the switch variable, and the last one for the
+  rest (default). They return the position of the variable in varOrder,
+  or -1 if no further switch is necessary (or possible).
+*/
 
-  // Infinite loop
+int SuccessorGenerator::assign_buckets_in_order(const ConstructionStep &step) {
+  int begin = step.begin, end = step.end;
+  int switch_var_no = step.switch_var_no;
   while(true) {
     // Test if no further switch is necessary (or possible).
     if(switch_var_no == varOrder.size())
-      return new GeneratorLeaf(op_indices);
+      return -1;
 
     // Get a pointer to the sorted Variables and its possible values size
     Variable *switch_var = varOrder[switch_var_no];
+    int switch_var_index = switch_var->get_index();
     int number_of_children = switch_var->get_range();
 
-    // Create a list for each possible value of the variable
-    vector<list<int> > ops_for_val_indices(number_of_children);
-    list<int> default_ops_indices;
-    list<int> applicable_ops_indices;
-    
-    bool all_ops_are_immediate = true;
-    bool var_is_interesting = false;
-    
-    // While there are operators in op_indices
-    while(!op_indices.empty()) {
-      // Get the top one
-      int op_index = op_indices.front();
-      op_indices.pop_front();
+    int default_bucket = number_of_children + 1;
+    bucket_starts.assign(number_of_children + 2, 0);
+    // smallest variable after switch_var in a default operator's next
+    // condition, -1 if none
+    int next_condition_var = -1;
+    for(int i = begin; i < end; i++) {
+      int op_index = op_indices[i];
       // Assert that the operator is a valid one (>0 and <max)
       assert(op_index >= 0 && op_index < next_condition_by_op.size());
       // Get condition iterator
-      Condition::const_iterator &cond_iter = next_condition_by_op[op_index];
-      // Assert that the size of the stored conditions is valid
+      const ConditionTable::Fact *&cond_iter = next_condition_by_op[op_index];
       assert(cond_iter - conditions[op_index].begin() >= 0);
       assert(cond_iter - conditions[op_index].begin() <= conditions[op_index].size());
-      // If the extract4ed condition is the last
+      int bucket;
       if(cond_iter == conditions[op_index].end()) {
-    	// Make the var interesting and add the operator to the applicable list
-    	  var_is_interesting = true;
-    	  applicable_ops_indices.push_back(op_index);
+	bucket = 0;
+      } else if(cond_iter->first == switch_var_index) {
+	bucket = 1 + cond_iter->second;
+	++cond_iter;
       } else {
-    	  // If there exists a condition, then not immediate,
-    	  all_ops_are_immediate = false;
-    	  // Get variable that presents a condition
-    	  Variable *var = cond_iter->first;
-    	  // Get index
-    	  int val = cond_iter->second;
-    	  // If the variable is the switch_var
-    	  if(var == switch_var) {
-    		  // Var is interesting, get next condition
-    		  var_is_interesting = true;
-    		  ++cond_iter;
-    		  // Store in the operator in the values indexed list
-    		  ops_for_val_indices[val].push_back(op_index);
-    	  } else {
-    		  // If the var is not the switch_var, add the operator to the default list
-    		  default_ops_indices.push_back(op_index);
-    	  }
+	bucket = default_bucket;
+	int var = cond_iter->first;
+	// Conditions on variables before switch_var can never be met by
+	// a switch any more.
+	if(var > switch_var_index &&
+	   (next_condition_var == -1 || var < next_condition_var))
+	  next_condition_var = var;
       }
+      buckets[i] = bucket;
+      bucket_starts[bucket]++;
     }
-    
+
+    int op_count = end - begin;
     // If there aren't any conditions
-    if(all_ops_are_immediate) {
-    	// Return the generator with the applicable indices
-      return new GeneratorLeaf(applicable_ops_indices);
-    } else if(var_is_interesting) {
-        // Else if the var is interesting --> appears in the conditioins of a operator
-      vector<GeneratorBase *> gen_for_val;
-      // Iterate over the possible values of the variable
-      for(int j = 0; j < number_of_children; j++) {
-    	  // Perform the same study for the next switch_var and the operators of each var value
-    	  // Add the returned GeneratorBase to gen_for_val, one for each child
-    	  gen_for_val.push_back(construct_recursive(switch_var_no + 1,
-						  ops_for_val_indices[j]));
-      }
-      // Perform the same study over the next variable for all default ops (affect a var)
-      GeneratorBase *default_sg = construct_recursive(switch_var_no + 1,
-						      default_ops_indices);
-      return new GeneratorSwitch(switch_var, applicable_ops_indices, gen_for_val, default_sg);
+    if(bucket_starts[0] == op_count)
+      return -1;
+    if(bucket_starts[default_bucket] == op_count) {
+      // this switch var can be left out because no operator depends on
+      // it, and so can every variable up to the next one in a condition
+      if(next_condition_var == -1)
+	switch_var_no = varOrder.size();
+      else
+	switch_var_no = first_switch_at_least[next_condition_var];
+      continue;
+    }
+    return switch_var_no;
+  }
+}
+
+int SuccessorGenerator::assign_buckets_by_cost(const ConstructionStep &step) {
+  int begin = step.begin, end = step.end;
+  // Count the conditions on each variable that are not decided yet.
+  vector<int> &candidates = candidate_vars;
+  candidates.clear();
+  for(int i = begin; i < end; i++) {
+    int op_index = op_indices[i];
+    if(remaining_conditions[op_index] == 0)
+      continue;
+    const Condition &condition = conditions[op_index];
+    for(int j = 0; j < condition.size(); j++) {
+      int var = condition[j].first;
+      int pos = first_switch_at_least[var];
+      if(is_consumed[condition_starts[op_index] + j] ||
+	 pos == varOrder.size() || varOrder[pos]->get_index() != var)
+	continue;
+      if(condition_counts[var]++ == 0)
+	candidates.push_back(var);
+    }
+  }
+  if(candidates.empty())
+    return -1;
+
+  // A lookup in a state with uniformly distributed values passes on
+  // only 1 / range of the operators with a condition on the switch
+  // variable. Switch on the variable that filters out the most, the one
+  // with the smallest index on ties.
+  int best_var = -1;
+  double best_filtered = 0;
+  for(int i = 0; i < candidates.size(); i++) {
+    int var = candidates[i];
+    int range = varOrder[first_switch_at_least[var]]->get_range();
+    double filtered = condition_counts[var] * (range - 1) / double(range);
+    if(best_var == -1 || filtered > best_filtered ||
+       (filtered == best_filtered && var < best_var)) {
+      best_var = var;
+      best_filtered = filtered;
+    }
+    condition_counts[var] = 0;
+  }
+
+  int switch_var_no = first_switch_at_least[best_var];
+  int number_of_children = varOrder[switch_var_no]->get_range();
+  int default_bucket = number_of_children + 1;
+  bucket_starts.assign(number_of_children + 2, 0);
+  for(int i = begin; i < end; i++) {
+    int op_index = op_indices[i];
+    int bucket = default_bucket;
+    if(remaining_conditions[op_index] == 0) {
+      bucket = 0;
     } else {
-      // this switch var can be left out because no operator depends on it
-      ++switch_var_no;
-      default_ops_indices.swap(op_indices);
+      // An operator can have several (contradictory) conditions on
+      // best_var; the first one not consumed by a switch above decides.
+      const Condition &condition = conditions[op_index];
+      const ConditionTable::Fact *fact = lower_bound(
+	condition.begin(), condition.end(), make_pair(best_var, 0));
+      int fact_no = fact - condition.begin();
+      while(fact != condition.end() && fact->first == best_var &&
+	    is_consumed[condition_starts[op_index] + fact_no]) {
+	++fact;
+	++fact_no;
+      }
+      if(fact != condition.end() && fact->first == best_var) {
+	bucket = 1 + fact->second;
+	is_consumed[condition_starts[op_index] + fact_no] = true;
+	remaining_conditions[op_index]--;
+      }
     }
+    buckets[i] = bucket;
+    bucket_starts[bucket]++;
+  }
+  // best_var was a candidate, so the switch consumes at least one
+  // condition and the construction terminates.
+  assert(bucket_starts[0] + bucket_starts[default_bucket] < end - begin);
+  return switch_var_no;
+}
+
+GeneratorBase *SuccessorGenerator::construct_node(
+  const ConstructionStep &step, vector<ConstructionStep> &steps) {
+  int begin = step.begin, end = step.end;
+  if(begin == end)
+    return empty_generator;
+
+  int switch_var_no;
+  if(context->get_switch_order() == SWITCH_ORDER_COST)
+    switch_var_no = assign_buckets_by_cost(step);
+  else
+    switch_var_no = assign_buckets_in_order(step);
+  Arena &arena = context->get_graph_arena();
+  if(switch_var_no == -1)
+    // Return the generator with the applicable indices
+    return new(arena) GeneratorLeaf(copy_operators(arena, op_indices,
+						   begin, end));
+  Variable *switch_var = varOrder[switch_var_no];
+  int number_of_children = switch_var->get_range();
+  int default_bucket = number_of_children + 1;
+
+  // Move the operators of each bucket together, keeping their order.
+  int start = begin;
+  for(int bucket = 0; bucket < bucket_starts.size(); bucket++) {
+    int size = bucket_starts[bucket];
+    bucket_starts[bucket] = start;
+    start += size;
+  }
+  for(int i = begin; i < end; i++)
+    partition_buffer[bucket_starts[buckets[i]]++] = op_indices[i];
+  copy(partition_buffer.begin() + begin, partition_buffer.begin() + end,
+       op_indices.begin() + begin);
+  // bucket_starts[bucket] is now the end of the bucket.
+
+  GeneratorSwitch *node = new(arena) GeneratorSwitch(
+    arena, switch_var, context->get_level(switch_var),
+    copy_operators(arena, op_indices, begin, bucket_starts[0]));
+  // The default operators and those of each value are distinguished
+  // by the following variables (in index order).
+  ConstructionStep default_step = {bucket_starts[default_bucket - 1],
+				   end, switch_var_no + 1,
+				   node->get_default_slot()};
+  steps.push_back(default_step);
+  for(int value = number_of_children - 1; value >= 0; value--) {
+    ConstructionStep value_step = {bucket_starts[value],
+				   bucket_starts[value + 1],
+				   switch_var_no + 1,
+				   node->get_child_slot(value)};
+    steps.push_back(value_step);
   }
+  return node;
 }
 
 SuccessorGenerator::SuccessorGenerator() {
   root = 0;
+  context = 0;
+  empty_generator = 0;
 }
 
 SuccessorGenerator::~SuccessorGenerator() {
-  delete root;
+  // root and the other nodes are released with the graph arena
+}
+
+void SuccessorGenerator::report(ostream &out) const {
+  GeneratorStatistics statistics = {0, 0, 0, 0};
+  double lookup_cost = root->collect_statistics(statistics);
+  out << "successor generator: " << statistics.switches << " switches, "
+      << statistics.leaves << " leaves, " << statistics.empty_nodes
+      << " empty nodes, " << statistics.operator_entries
+      << " operator entries, expected lookup cost " << lookup_cost
+      << " (nodes and operators visited)" << endl;
 }
 
 void SuccessorGenerator::dump() const {
@@ -292,5 +651,38 @@ void SuccessorGenerator::dump() const {
   root->dump("  ");
 }
 void SuccessorGenerator::generate_cpp_input(ofstream &outfile) const {
-  root->generate_cpp_input(outfile);
+  root->generate_cpp_input(outfile, *context);
+}
+
+void renumber_operators(PipelineContext &context,
+			const vector<Variable *> &variables,
+			OperatorTable &operators) {
+  // The shape of the generator does not depend on the operator
+  // numbers, and the operators of each node keep their relative order
+  // in it. Numbering the operators in the order in which the generator
+  // lists them thus makes every list of the rebuilt generator a range.
+  // This generator is only used for its lists; its nodes stay in the
+  // graph arena.
+  SuccessorGenerator generator(context, variables, operators);
+  vector<Span<int> > lists;
+  generator.root->append_operator_lists(lists);
+
+  vector<int> order;
+  order.reserve(operators.size());
+  vector<pair<int, int> > list_order; // (level of first effect, operator)
+  for(int i = 0; i < lists.size(); i++) {
+    // Within a list, the operators on the same variable are kept
+    // together.
+    list_order.clear();
+    for(int j = 0; j < lists[i].size(); j++) {
+      int op_no = lists[i][j];
+      Variable *effect_var = operators[op_no].get_pre_post()[0].var;
+      list_order.push_back(make_pair(context.get_level(effect_var), op_no));
+    }
+    sort(list_order.begin(), list_order.end());
+    for(int j = 0; j < list_order.size(); j++)
+      order.push_back(list_order[j].second);
+  }
+  assert(order.size() == operators.size());
+  operators.reorder(order);
 }
@@ -23,36 +23,134 @@
 #ifndef SUCCESSOR_GENERATOR_H
 #define SUCCESSOR_GENERATOR_H
 
-#include <list>
+#include "arena.h"
+#include "condition_table.h"
+#include "span.h"
+
 #include <vector>
 #include <fstream>
-#include <map>
+#include <iostream>
 using namespace std;
 
+/*
+  Output format (between begin_SG and end_SG, one item per line). A node
+  is either a leaf
+
+    check <n>, then the numbers of the n operators that are applicable
+    (check 0 is the empty node)
+
+  or a switch on the variable at <level>
+
+    switch <level>
+    check <n>, then the n operators applicable whatever its value
+    the children, as chosen by the encoding (see below)
+    the default child: the node of the operators without a condition
+    on the variable
+
+  The children of a switch are written in one of three encodings,
+  selected with PipelineContext::set_successor_generator_encoding():
+
+  dense (default): one node per value, in order of value.
+
+  runs: like dense, but each run of consecutive empty children
+    (including the default child) is one line "empty <count>".
+
+  sparse: each switch picks the shortest of the following lists. Empty
+    children are left out of the sparse and bitmap lists.
+      dense
+        one node per value, as above
+      sparse <k>
+        k times a value and then its node, by ascending value, so that
+        the value can be found by binary search
+      bitmap <k> <m> <word 1> ... <word m>
+        bit v % 32 of word v / 32 + 1 is set iff the child of value v is
+        not empty; the k non-empty children follow by ascending value, so
+        the child of v is found by counting the set bits before v
+
+  With PipelineContext::set_operator_ranges(), a list of consecutive
+  operators (of a leaf, or the immediate operators of a switch) is
+  written as "range <first> <n>" instead of "check <n>" and the n
+  operators; see renumber_operators().
+*/
+
 class GeneratorBase;
-class Operator;
+class OperatorTable;
+class PipelineContext;
 class Variable;
 
 class SuccessorGenerator {
   GeneratorBase *root;
+  PipelineContext *context;
 
-  typedef vector<pair<Variable *, int> > Condition;
-  GeneratorBase *construct_recursive(int switchVarNo, list<int> &ops);
+  // The generator nodes and their operator lists are allocated in the
+  // context's graph arena; the conditions are sets in its
+  // ConditionTable.
+  typedef Span<ConditionTable::Fact> Condition;
+
+  // A subtree still to be built: it distinguishes the operators
+  // op_indices[begin .. end - 1], in index order starting with
+  // varOrder[switch_var_no], and is stored in *slot.
+  struct ConstructionStep {
+    int begin;
+    int end;
+    int switch_var_no;
+    GeneratorBase **slot;
+  };
+  GeneratorBase *construct_node(const ConstructionStep &step,
+				vector<ConstructionStep> &steps);
+  int assign_buckets_in_order(const ConstructionStep &step);
+  int assign_buckets_by_cost(const ConstructionStep &step);
   SuccessorGenerator(const SuccessorGenerator &copy);
 
   vector<Condition> conditions;
-  vector<Condition::const_iterator> next_condition_by_op;
+  vector<const ConditionTable::Fact *> next_condition_by_op;
   vector<Variable *> varOrder;
+  // Position in varOrder of the first variable with at least the given
+  // index.
+  vector<int> first_switch_at_least;
+  GeneratorBase *empty_generator; // shared by all empty subtrees
+
+  // The operators are partitioned in place; every subtree owns a range
+  // of op_indices. buckets and partition_buffer are scratch space of
+  // the same size.
+  vector<int> op_indices;
+  vector<int> buckets;
+  vector<int> partition_buffer;
+  vector<int> bucket_starts;
+
+  // Used when switching by cost, where the conditions of an operator
+  // are not decided in order: whether each condition has been decided
+  // (starting at condition_starts[op]), and how many have not.
+  vector<int> condition_starts;
+  vector<bool> is_consumed;
+  vector<int> remaining_conditions;
+  vector<int> condition_counts; // indexed by variable index
+  vector<int> candidate_vars;
 
   // private copy constructor to forbid copying;
   // typical idiom for classes with non-trivial destructors
 public:
   SuccessorGenerator();
-  SuccessorGenerator(const vector<Variable *> &variables,
-		     const vector<Operator> &operators);
+  SuccessorGenerator(PipelineContext &context,
+		     const vector<Variable *> &variables,
+		     const OperatorTable &operators);
   ~SuccessorGenerator();
   void dump() const;
+  // Prints the size and expected lookup cost of the generator.
+  void report(ostream &out) const;
   void generate_cpp_input(ofstream &outfile) const;
+
+  friend void renumber_operators(PipelineContext &context,
+				 const vector<Variable *> &variables,
+				 OperatorTable &operators);
 };
 
+// Renumbers the operators in the order in which a successor generator
+// over them lists them, so that the operators of each of its nodes are
+// consecutive, and those with the same effect variable are adjacent
+// within a node. Call before anything refers to operator numbers.
+void renumber_operators(PipelineContext &context,
+			const vector<Variable *> &variables,
+			OperatorTable &operators);
+
 #endif
@@ -0,0 +1,143 @@
+#!/bin/sh
+# Runs the preprocessor tests; "make check" builds the programs and
+# test drivers first. The tasks are small translator outputs, and
+# expected/ holds what preprocess writes for them.
+
+cd "$(dirname "$0")/.." || exit 1
+ROOT=$(pwd)
+TESTS=$ROOT/tests
+SCRATCH=$(mktemp -d) || exit 1
+trap 'rm -rf "$SCRATCH"' EXIT
+failures=0
+
+fail() {
+  echo "FAILED: $1"
+  failures=$((failures + 1))
+}
+
+# run <task> [options]: runs preprocess in the scratch directory and
+# fails unless it succeeds.
+run() {
+  task=$1
+  shift
+  (cd "$SCRATCH" && "$ROOT/preprocess" "$task" "$@" > run.log 2>&1) ||
+    fail "preprocess $task $*"
+}
+
+# same <expected> <output> <what>
+same() {
+  cmp -s "$1" "$SCRATCH/$2" || fail "$3"
+  rm -f "$SCRATCH/$2"
+}
+
+# exits_with_error <task> [options]: preprocess must report the error
+# and exit with code 1, not crash or hang.
+exits_with_error() {
+  task=$1
+  shift
+  (cd "$SCRATCH" && "$ROOT/preprocess" "$task" "$@" > run.log 2>&1)
+  [ $? -eq 1 ] || fail "preprocess $(basename "$task") $* exits with 1"
+}
+
+for name in basic numeric; do
+  run "$TESTS/${name}_output.sas"
+  same "$TESTS/expected/${name}_output_prepro" ${name}_output_prepro \
+    "$name: output"
+  run "$TESTS/${name}_output.sas" --parallel-parse
+  same "$TESTS/expected/${name}_output_prepro" ${name}_output_prepro \
+    "$name: output with --parallel-parse"
+done
+
+# operators with a repeated condition and with contradictory conditions
+# on one variable; the cost order used to loop forever on them
+run "$TESTS/conflicting_output.sas"
+same "$TESTS/expected/conflicting_output_prepro" conflicting_output_prepro \
+  "conflicting: output"
+run "$TESTS/conflicting_output.sas" --sg-order cost --prefix cost
+same "$TESTS/expected/conflicting_cost_output_prepro" cost_output_prepro \
+  "conflicting: output with --sg-order cost"
+
+# several runs at once, in threads of one process
+(cd "$SCRATCH" &&
+  "$ROOT/obj/test_concurrent_runs" "$TESTS" > concurrent.log 2>&1) ||
+  { grep FAILED "$SCRATCH/concurrent.log"; fail "test_concurrent_runs"; }
+
+# writing the output allocates the same for both tasks
+(cd "$SCRATCH" &&
+  "$ROOT/obj/test_output_allocations" "$TESTS" > allocations.log 2>&1) ||
+  { grep FAILED "$SCRATCH/allocations.log"; fail "test_output_allocations"; }
+
+# the optional output encodings decode to the plain output
+(cd "$SCRATCH" &&
+  "$ROOT/obj/test_output_encodings" "$TESTS" > encodings.log 2>&1) ||
+  { grep FAILED "$SCRATCH/encodings.log"; fail "test_output_encodings"; }
+
+# relevance for many goal sets in one sweep
+"$ROOT/obj/test_relevance" "$TESTS" > "$SCRATCH/relevance.log" 2>&1 ||
+  { grep FAILED "$SCRATCH/relevance.log"; fail "test_relevance"; }
+
+# tokenizer: the last token ends the file, and truncated files
+(cd "$SCRATCH" && "$ROOT/obj/test_tokenizer") || fail "test_tokenizer"
+size=$(wc -c < "$TESTS/numeric_output.sas")
+head -c $((size - 1)) "$TESTS/numeric_output.sas" > "$SCRATCH/cut_output.sas"
+run "$SCRATCH/cut_output.sas"
+same "$TESTS/expected/numeric_output_prepro" cut_output_prepro \
+  "numeric: output without the final newline"
+for length in 0 1 100 1000 2000 3000 $((size - 2)); do
+  head -c $length "$TESTS/numeric_output.sas" > "$SCRATCH/cut_output.sas"
+  exits_with_error "$SCRATCH/cut_output.sas"
+  exits_with_error "$SCRATCH/cut_output.sas" --parallel-parse
+done
+
+# input from a pipe, written in pieces while preprocess reads it
+(head -c 1000 "$TESTS/numeric_output.sas"; sleep 1
+ tail -c +1001 "$TESTS/numeric_output.sas") |
+  (cd "$SCRATCH" && "$ROOT/preprocess" - --prefix pipe > run.log 2>&1) ||
+  fail "preprocess from a pipe"
+same "$TESTS/expected/numeric_output_prepro" pipe_output_prepro \
+  "numeric: output from a pipe"
+
+# binary tasks: converting to the binary format and reading it back
+# must give the same output. The numeric task has numeric and runtime
+# cost effects, runtime operator costs and axioms.
+for name in basic numeric; do
+  "$ROOT/sas-to-binary" "$TESTS/${name}_output.sas" \
+    "$SCRATCH/${name}_output.sasb" > /dev/null ||
+    fail "sas-to-binary $name"
+  run "$SCRATCH/${name}_output.sasb"
+  same "$TESTS/expected/${name}_output_prepro" ${name}_output_prepro \
+    "$name: output from the binary task"
+done
+cat "$SCRATCH/numeric_output.sasb" |
+  (cd "$SCRATCH" && "$ROOT/preprocess" - --prefix pipe > run.log 2>&1) ||
+  fail "preprocess on a binary task from a pipe"
+same "$TESTS/expected/numeric_output_prepro" pipe_output_prepro \
+  "numeric: output from the binary task from a pipe"
+
+# corrupt binary tasks: truncated files, a count larger than its
+# section, and a variable number out of range
+binary=$SCRATCH/numeric_output.sasb
+size=$(wc -c < "$binary")
+for length in 0 10 600 1000 $((size - 1)); do
+  head -c $length "$binary" > "$SCRATCH/cut_output.sasb"
+  exits_with_error "$SCRATCH/cut_output.sasb"
+done
+# patch <offset of the section tag> <bytes>: overwrites the start of
+# the payload of a section of the numeric task
+patch() {
+  cp "$binary" "$SCRATCH/bad_output.sasb"
+  printf "$2" | dd of="$SCRATCH/bad_output.sasb" bs=1 seek=$(($1 + 12)) \
+    conv=notrunc 2> /dev/null
+}
+shared=$(grep -obUa SHRD "$binary" | cut -d: -f1)
+patch $shared '\377\377\377\017'
+exits_with_error "$SCRATCH/bad_output.sasb"
+goal=$(grep -obUa GOAL "$binary" | cut -d: -f1)
+patch $goal '\001\177'
+exits_with_error "$SCRATCH/bad_output.sasb"
+
+if [ $failures -ne 0 ]; then
+  echo "$failures tests failed."
+  exit 1
+fi
+echo "All tests passed."
@@ -0,0 +1,106 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+/* Runs several preprocessing runs at once, in threads with their own
+ * PipelineContext, and checks that each writes the same output as a
+ * run on its own. Called with the tests directory as the argument;
+ * the outputs are written to the current directory.
+ */
+
+#include "../pipeline.h"
+#include "../pipeline_context.h"
+
+#include <pthread.h>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+struct Run {
+  string input;
+  string prefix;
+  string expected;
+  int parse_threads;
+};
+
+static void *execute_run(void *arg) {
+  const Run &run = *static_cast<const Run *>(arg);
+  PreprocessOptions options;
+  options.input = run.input.c_str();
+  options.prefix = run.prefix.c_str();
+  PipelineContext context;
+  context.set_do_not_prune_variables(true); // as in planner.cc
+  context.set_parse_threads(run.parse_threads);
+  run_preprocess(options, context);
+  return 0;
+}
+
+static string read_file(const string &filename) {
+  ifstream in(filename.c_str(), ios::in | ios::binary);
+  ostringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+int main(int argc, const char **argv) {
+  if(argc != 2) {
+    cout << "usage: " << argv[0] << " <tests directory>" << endl;
+    return 1;
+  }
+  string tests = argv[1];
+  const char *tasks[] = {"basic", "numeric"};
+  vector<Run> runs(8);
+  for(int i = 0; i < runs.size(); i++) {
+    string task = tasks[i % 2];
+    ostringstream prefix;
+    prefix << "run" << i;
+    runs[i].input = tests + "/" + task + "_output.sas";
+    runs[i].prefix = prefix.str();
+    runs[i].expected = tests + "/expected/" + task + "_output_prepro";
+    // Half of the runs parse with threads of their own.
+    runs[i].parse_threads = i < 4 ? 1 : 2;
+  }
+
+  vector<pthread_t> threads(runs.size());
+  for(int i = 0; i < runs.size(); i++) {
+    if(pthread_create(&threads[i], 0, execute_run, &runs[i]) != 0) {
+      cout << "Could not start run " << i << "." << endl;
+      return 1;
+    }
+  }
+  for(int i = 0; i < runs.size(); i++)
+    pthread_join(threads[i], 0);
+
+  int failures = 0;
+  for(int i = 0; i < runs.size(); i++) {
+    string output = runs[i].prefix + "_output_prepro";
+    if(read_file(output) != read_file(runs[i].expected)) {
+      cout << "FAILED: output of concurrent run " << i << " ("
+	   << runs[i].input << ")" << endl;
+      failures++;
+    }
+  }
+  if(failures != 0)
+    return 1;
+  cout << "concurrent run tests passed" << endl;
+  return 0;
+}
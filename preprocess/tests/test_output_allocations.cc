@@ -0,0 +1,156 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+/* Counts the heap allocations made while the output is written, with
+ * a replaced operator new. generate_cpp_input writes from the data
+ * built by the pipeline; it must not copy it, so the number of
+ * allocations must not grow with the size of the task. Called with
+ * the tests directory as the argument; the outputs are written to the
+ * current directory.
+ */
+
+#include "../axiom.h"
+#include "../causal_graph.h"
+#include "../domain_transition_graph.h"
+#include "../helper_functions.h"
+#include "../operator.h"
+#include "../pipeline_context.h"
+#include "../state.h"
+#include "../successor_generator.h"
+#include "../tokenizer.h"
+#include "../variable.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+using namespace std;
+
+static bool counting = false;
+static long allocation_count = 0;
+
+void *operator new(size_t size) throw(bad_alloc) {
+  if(counting)
+    allocation_count++;
+  void *ptr = malloc(size ? size : 1);
+  if(!ptr)
+    throw bad_alloc();
+  return ptr;
+}
+
+void *operator new[](size_t size) throw(bad_alloc) {
+  return operator new(size);
+}
+
+void operator delete(void *ptr) throw() {
+  free(ptr);
+}
+
+void operator delete[](void *ptr) throw() {
+  free(ptr);
+}
+
+// Output settings to test.
+struct OutputMode {
+  const char *description;
+  OperatorNameMode operator_names;
+  SuccessorGeneratorEncoding encoding;
+  bool any_value_transitions;
+  bool operator_ranges;
+};
+
+static const OutputMode modes[] = {
+  {"default", OPERATOR_NAMES_INLINE, SG_ENCODING_DENSE, false, false},
+  {"operator name section", OPERATOR_NAMES_SECTION, SG_ENCODING_DENSE,
+   false, false},
+  {"operator name sidecar", OPERATOR_NAMES_SIDECAR, SG_ENCODING_DENSE,
+   false, false},
+  {"empty runs", OPERATOR_NAMES_INLINE, SG_ENCODING_EMPTY_RUNS, false, false},
+  {"sparse, any-value transitions, ranges", OPERATOR_NAMES_INLINE,
+   SG_ENCODING_SPARSE, true, true}
+};
+
+// Runs the pipeline like run_preprocess and returns the number of
+// allocations made by generate_cpp_input.
+static long count_output_allocations(const string &input,
+				     const OutputMode &mode) {
+  PipelineContext context;
+  context.set_do_not_prune_variables(true);
+  context.set_operator_names(mode.operator_names);
+  context.set_successor_generator_encoding(mode.encoding);
+  context.set_any_value_transitions(mode.any_value_transitions);
+  context.set_operator_ranges(mode.operator_ranges);
+  string metric;
+  vector<Variable *> variables;
+  vector<Variable> internal_variables;
+  State initial_state;
+  vector<pair<Variable *, int> > goals;
+  OperatorTable operators(context.get_strings(), context.get_conditions());
+  vector<Axiom> axioms;
+  vector<DomainTransitionGraph> transition_graphs;
+  vector<Variable *> shared_vars;
+  vector<int> shared_vars_number;
+
+  Tokenizer in(input.c_str());
+  in.read_string(); // name
+  read_preprocessed_problem_description
+    (context, in, metric, internal_variables, variables, initial_state,
+     goals, operators, axioms, shared_vars, shared_vars_number);
+  context.set_variable_count(variables.size());
+  CausalGraph causal_graph(context, variables, operators, axioms, goals);
+  const vector<Variable *> &ordering = causal_graph.get_variable_ordering();
+  strip_operators(context, operators);
+  strip_axioms(context, axioms);
+  build_DTGs(context, ordering, variables, operators, axioms,
+	     transition_graphs);
+  SuccessorGenerator successor_generator(context, ordering, operators);
+
+  allocation_count = 0;
+  counting = true;
+  generate_cpp_input(context, false, ordering, metric, initial_state, goals,
+		     operators, axioms, successor_generator,
+		     transition_graphs, causal_graph, "", shared_vars,
+		     shared_vars_number, variables, "allocations");
+  counting = false;
+  return allocation_count;
+}
+
+int main(int argc, const char **argv) {
+  if(argc != 2) {
+    cout << "usage: " << argv[0] << " <tests directory>" << endl;
+    return 1;
+  }
+  string tests = argv[1];
+  int failures = 0;
+  for(int i = 0; i < sizeof(modes) / sizeof(modes[0]); i++) {
+    long basic = count_output_allocations(tests + "/basic_output.sas",
+					  modes[i]);
+    long numeric = count_output_allocations(tests + "/numeric_output.sas",
+					    modes[i]);
+    cout << modes[i].description << ": " << basic << " and " << numeric
+	 << " allocations" << endl;
+    if(basic != numeric) {
+      cout << "FAILED: " << modes[i].description
+	   << ": the allocations depend on the task" << endl;
+      failures++;
+    }
+  }
+  return failures;
+}
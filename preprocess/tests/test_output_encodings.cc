@@ -0,0 +1,565 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+/* Decodes the optional output encodings (any-value DTG transitions,
+ * the runs and sparse successor generator encodings and operator
+ * ranges) back into the plain output, and checks that it is the output
+ * of a run without them. It also maps renumbered operators back to
+ * their original numbers, and compares the operators that the successor
+ * generators of both switch orders return in every state. Called with
+ * the tests directory as the argument; the outputs are written to the
+ * current directory.
+ */
+
+#include "../pipeline.h"
+#include "../pipeline_context.h"
+#include "../tokenizer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// How often each encoding was decoded, over all tests.
+struct EncodingCounts {
+  int empty_runs;
+  int dense_lists;
+  int sparse_lists;
+  int bitmap_lists;
+  int operator_ranges;
+  int any_value_transitions;
+};
+
+static EncodingCounts counts;
+
+// When set, the original number of each operator of a renumbered
+// output; the decoder writes the original numbers and sorts the lists
+// of operators.
+static vector<int> original_operators;
+
+static void fail(const string &message) {
+  cout << "FAILED: " << message << endl;
+  exit(1);
+}
+
+static void expect(Tokenizer &in, const char *word) {
+  if(in.read_string() != word)
+    fail(string("expected '") + word + "'");
+}
+
+// Writes "check <n>" and the operators, for a list written as either
+// that or "range <first> <n>"; word is the first word of the list.
+static void decode_operators(Tokenizer &in, const string &word,
+			     ostream &out) {
+  vector<int> operators;
+  int count = in.read_int();
+  if(word == "range") {
+    int first = count;
+    count = in.read_int();
+    for(int i = 0; i < count; i++)
+      operators.push_back(first + i);
+    counts.operator_ranges++;
+  } else if(word == "check") {
+    for(int i = 0; i < count; i++)
+      operators.push_back(in.read_int());
+  } else {
+    fail("unexpected '" + word + "' instead of an operator list");
+  }
+  if(!original_operators.empty()) {
+    for(int i = 0; i < count; i++)
+      operators[i] = original_operators[operators[i]];
+    sort(operators.begin(), operators.end());
+  }
+  out << "check " << count << endl;
+  for(int i = 0; i < count; i++)
+    out << operators[i] << endl;
+}
+
+static void decode_node(Tokenizer &in, const string &word,
+			const vector<int> &ranges, ostream &out);
+
+// Writes the next child of a switch in a dense list. empty_run is the
+// number of empty children still to come from an "empty <count>"
+// line; lookahead is the first word of the child if it has been read.
+static void decode_child(Tokenizer &in, string &lookahead, int &empty_run,
+			 const vector<int> &ranges, ostream &out) {
+  if(empty_run > 0) {
+    empty_run--;
+    out << "check 0" << endl;
+    return;
+  }
+  string word = lookahead.empty() ? in.read_string() : lookahead;
+  lookahead.clear();
+  if(word == "empty") {
+    empty_run = in.read_int();
+    if(empty_run < 1)
+      fail("empty run without children");
+    empty_run--;
+    out << "check 0" << endl;
+    counts.empty_runs++;
+  } else {
+    decode_node(in, word, ranges, out);
+  }
+}
+
+static void decode_node(Tokenizer &in, const string &word,
+			const vector<int> &ranges, ostream &out) {
+  if(word != "switch") {
+    decode_operators(in, word, out);
+    return;
+  }
+  int level = in.read_int();
+  if(level < 0 || level >= ranges.size())
+    fail("switch on an unknown variable");
+  int range = ranges[level];
+  out << "switch " << level << endl;
+  decode_operators(in, in.read_string(), out);
+
+  string lookahead = in.read_string();
+  int empty_run = 0;
+  if(lookahead == "sparse") {
+    int children = in.read_int();
+    int next_value = 0;
+    for(int i = 0; i < children; i++) {
+      int value = in.read_int();
+      if(value < next_value || value >= range)
+	fail("sparse list out of order");
+      for(; next_value < value; next_value++)
+	out << "check 0" << endl;
+      decode_node(in, in.read_string(), ranges, out);
+      next_value = value + 1;
+    }
+    for(; next_value < range; next_value++)
+      out << "check 0" << endl;
+    lookahead.clear();
+    counts.sparse_lists++;
+  } else if(lookahead == "bitmap") {
+    int children = in.read_int();
+    int words = in.read_int();
+    if(words != (range + 31) / 32)
+      fail("bitmap of the wrong size");
+    vector<unsigned long> bitmap(words);
+    for(int i = 0; i < words; i++)
+      bitmap[i] = strtoul(in.read_string().c_str(), 0, 10);
+    for(int value = 0; value < range; value++) {
+      if(bitmap[value / 32] & (1UL << (value % 32))) {
+	decode_node(in, in.read_string(), ranges, out);
+	children--;
+      } else {
+	out << "check 0" << endl;
+      }
+    }
+    if(children != 0)
+      fail("bitmap does not match the number of children");
+    lookahead.clear();
+    counts.bitmap_lists++;
+  } else {
+    if(lookahead == "dense") {
+      lookahead.clear();
+      counts.dense_lists++;
+    }
+    for(int value = 0; value < range; value++)
+      decode_child(in, lookahead, empty_run, ranges, out);
+  }
+  out << "default" << endl;
+  decode_child(in, lookahead, empty_run, ranges, out);
+  if(empty_run != 0)
+    fail("empty run past the end of a switch");
+}
+
+// A DTG transition as written: target, operator, the number of
+// conditions and the conditions.
+static vector<int> read_transition(Tokenizer &in) {
+  vector<int> transition;
+  transition.push_back(in.read_int());
+  transition.push_back(in.read_int());
+  int conditions = in.read_int();
+  transition.push_back(conditions);
+  for(int i = 0; i < 2 * conditions; i++)
+    transition.push_back(in.read_int());
+  return transition;
+}
+
+// Writes the transitions of a DTG by source value, as sorted sets.
+// With any_value, the list of any-value transitions that ends the DTG
+// is added to all values other than their target. The transitions of
+// derived variables belong to axioms, which keep their numbers.
+static void decode_dtg(Tokenizer &in, int range, bool derived,
+		       bool any_value, ostream &out) {
+  vector<vector<vector<int> > > by_value(range);
+  for(int value = 0; value < range; value++) {
+    int count = in.read_int();
+    for(int i = 0; i < count; i++)
+      by_value[value].push_back(read_transition(in));
+  }
+  if(any_value) {
+    int count = in.read_int();
+    for(int i = 0; i < count; i++) {
+      vector<int> transition = read_transition(in);
+      for(int value = 0; value < range; value++)
+	if(value != transition[0])
+	  by_value[value].push_back(transition);
+      counts.any_value_transitions++;
+    }
+  }
+  for(int value = 0; value < range; value++) {
+    vector<vector<int> > &transitions = by_value[value];
+    for(int i = 0; !derived && !original_operators.empty() &&
+	  i < transitions.size(); i++)
+      transitions[i][1] = original_operators[transitions[i][1]];
+    sort(transitions.begin(), transitions.end());
+    transitions.erase(unique(transitions.begin(), transitions.end()),
+		      transitions.end());
+    out << "from " << value << ": " << transitions.size() << endl;
+    for(int i = 0; i < transitions.size(); i++) {
+      for(int j = 0; j < transitions[i].size(); j++)
+	out << " " << transitions[i][j];
+      out << endl;
+    }
+  }
+}
+
+// The ranges of the variables, by level, and if given their axiom
+// layers (-1 if not derived).
+static vector<int> read_ranges(Tokenizer &in, vector<int> *layers = 0) {
+  in.skip_past("begin_variables");
+  vector<int> ranges(in.read_int());
+  for(int i = 0; i < ranges.size(); i++) {
+    in.skip_token(); // name
+    ranges[i] = in.read_int();
+    int layer = in.read_int();
+    if(layers)
+      layers->push_back(layer);
+    in.skip_token(); // isTotalTime
+  }
+  return ranges;
+}
+
+// The successor generator and DTGs of an output file, in plain form.
+static string decode_output(const string &filename, bool any_value) {
+  Tokenizer in(filename.c_str());
+  vector<int> layers;
+  vector<int> ranges = read_ranges(in, &layers);
+  ostringstream out;
+  in.skip_past("begin_SG");
+  decode_node(in, in.read_string(), ranges, out);
+  expect(in, "end_SG");
+  for(int i = 0; i < ranges.size(); i++) {
+    expect(in, "begin_DTG");
+    decode_dtg(in, ranges[i], layers[i] != -1, any_value, out);
+    expect(in, "end_DTG");
+  }
+  return out.str();
+}
+
+// A node of a successor generator in the dense encoding: its operators
+// and, for a switch, its children by value and then the default child.
+struct GeneratorNode {
+  int level; // -1 for a leaf
+  vector<int> operators;
+  vector<int> children; // indices of the nodes
+};
+
+// Reads a node and its subtree and returns the index of the node.
+static int read_generator(Tokenizer &in, const vector<int> &ranges,
+			  vector<GeneratorNode> &nodes) {
+  int index = nodes.size();
+  nodes.push_back(GeneratorNode());
+  int level = -1;
+  string word = in.read_string();
+  if(word == "switch") {
+    level = in.read_int();
+    if(level < 0 || level >= ranges.size())
+      fail("switch on an unknown variable");
+    word = in.read_string();
+  }
+  if(word != "check")
+    fail("unexpected '" + word + "' in a dense successor generator");
+  nodes[index].level = level;
+  int count = in.read_int();
+  for(int i = 0; i < count; i++)
+    nodes[index].operators.push_back(in.read_int());
+  for(int value = 0; level != -1 && value <= ranges[level]; value++) {
+    int child = read_generator(in, ranges, nodes);
+    nodes[index].children.push_back(child);
+  }
+  return index;
+}
+
+// Appends the operators the generator returns in the state, which
+// holds the value of each variable by level.
+static void collect_operators(const vector<GeneratorNode> &nodes, int index,
+			      const vector<int> &state, vector<int> &result) {
+  const GeneratorNode &node = nodes[index];
+  result.insert(result.end(), node.operators.begin(), node.operators.end());
+  if(node.level != -1) {
+    collect_operators(nodes, node.children[state[node.level]], state, result);
+    collect_operators(nodes, node.children.back(), state, result);
+  }
+}
+
+// Counts the states in which the successor generators of two outputs of
+// the same task return different sets of operators. The test tasks are
+// small enough to try every state.
+static int count_differing_states(const string &filename,
+				  const string &other_filename) {
+  Tokenizer in(filename.c_str()), other_in(other_filename.c_str());
+  vector<int> ranges = read_ranges(in);
+  if(read_ranges(other_in) != ranges)
+    fail("outputs with different variables");
+  vector<GeneratorNode> nodes, other_nodes;
+  in.skip_past("begin_SG");
+  read_generator(in, ranges, nodes);
+  other_in.skip_past("begin_SG");
+  read_generator(other_in, ranges, other_nodes);
+
+  int differing = 0;
+  vector<int> state(ranges.size(), 0);
+  vector<int> result, other_result;
+  while(true) {
+    result.clear();
+    other_result.clear();
+    collect_operators(nodes, 0, state, result);
+    collect_operators(other_nodes, 0, state, other_result);
+    sort(result.begin(), result.end());
+    sort(other_result.begin(), other_result.end());
+    if(result != other_result)
+      differing++;
+    // next state, counting with the last level fastest
+    int level = ranges.size() - 1;
+    while(level >= 0 && ++state[level] >= ranges[level])
+      state[level--] = 0;
+    if(level < 0)
+      return differing;
+  }
+}
+
+static string read_file(const string &filename) {
+  ifstream in(filename.c_str(), ios::in | ios::binary);
+  ostringstream content;
+  content << in.rdbuf();
+  return content.str();
+}
+
+// Everything outside the successor generator and the DTGs.
+static string strip_encoded_sections(const string &output) {
+  string::size_type begin = output.find("\nbegin_SG\n");
+  string::size_type end = output.rfind("\nend_DTG\n");
+  if(begin == string::npos || end == string::npos)
+    fail("output without successor generator or DTGs");
+  return output.substr(0, begin) + output.substr(end);
+}
+
+// Splits off the operator section: returns the text of each operator
+// block and leaves the rest of the output.
+static vector<string> split_operators(const string &output, string &rest) {
+  string::size_type pos = output.find("\nend_goal\n");
+  if(pos == string::npos)
+    fail("output without goal section");
+  pos = output.find('\n', pos + 10) + 1; // after the operator count
+  rest = output.substr(0, pos);
+  vector<string> blocks;
+  while(output.compare(pos, 15, "begin_operator\n") == 0) {
+    string::size_type end = output.find("\nend_operator\n", pos);
+    if(end == string::npos)
+      fail("operator without end_operator");
+    end += 14;
+    blocks.push_back(output.substr(pos, end - pos));
+    pos = end;
+  }
+  rest += output.substr(pos);
+  return blocks;
+}
+
+// Finds the original number of each operator of a renumbered output by
+// its block in the operator section; fails unless the operators are a
+// permutation of the original ones. Returns whether they moved.
+static bool find_original_operators(const string &original,
+				    const string &renumbered) {
+  string rest, renumbered_rest;
+  vector<string> blocks = split_operators(original, rest);
+  vector<string> renumbered_blocks =
+    split_operators(renumbered, renumbered_rest);
+  if(strip_encoded_sections(rest) !=
+     strip_encoded_sections(renumbered_rest) ||
+     blocks.size() != renumbered_blocks.size())
+    fail("renumbering changed more than the operator order");
+  // Identical operators are interchangeable, so the first unused one
+  // is taken.
+  map<string, vector<int> > numbers;
+  for(int i = blocks.size() - 1; i >= 0; i--)
+    numbers[blocks[i]].push_back(i);
+  original_operators.clear();
+  bool moved = false;
+  for(int i = 0; i < renumbered_blocks.size(); i++) {
+    vector<int> &candidates = numbers[renumbered_blocks[i]];
+    if(candidates.empty())
+      fail("renumbered operator without an original");
+    original_operators.push_back(candidates.back());
+    candidates.pop_back();
+    if(original_operators.back() != i)
+      moved = true;
+  }
+  return moved;
+}
+
+struct Encoding {
+  const char *name;
+  bool renumber_operators;
+  SuccessorGeneratorEncoding encoding;
+  bool any_value_transitions;
+  bool operator_ranges;
+};
+
+static const Encoding encodings[] = {
+  {"runs", false, SG_ENCODING_EMPTY_RUNS, false, false},
+  {"sparse", false, SG_ENCODING_SPARSE, true, false},
+  {"ranges", true, SG_ENCODING_SPARSE, true, true}
+};
+
+// The plain output with the original and with renumbered operators.
+static const Encoding original_numbers =
+  {"original", false, SG_ENCODING_DENSE, false, false};
+static const Encoding new_numbers =
+  {"renumbered", true, SG_ENCODING_DENSE, false, false};
+
+// Writes the output of the task with the encoding, or without the
+// optional encodings but with the same operator numbering if plain is
+// set, and returns its file name.
+static string run(const string &input, const string &prefix,
+		  const Encoding &encoding, bool plain) {
+  PreprocessOptions options;
+  options.input = input.c_str();
+  options.prefix = prefix.c_str();
+  options.renumber_operators = encoding.renumber_operators;
+  PipelineContext context;
+  context.set_do_not_prune_variables(true); // as in planner.cc
+  if(!plain) {
+    context.set_successor_generator_encoding(encoding.encoding);
+    context.set_any_value_transitions(encoding.any_value_transitions);
+    context.set_operator_ranges(encoding.operator_ranges);
+  }
+  run_preprocess(options, context);
+  return prefix + "_output_prepro";
+}
+
+// Writes the output of the task with the switch order and returns its
+// file name.
+static string run_in_order(const string &input, const string &prefix,
+			   SwitchOrder order) {
+  PreprocessOptions options;
+  options.input = input.c_str();
+  options.prefix = prefix.c_str();
+  PipelineContext context;
+  context.set_do_not_prune_variables(true); // as in planner.cc
+  context.set_switch_order(order);
+  run_preprocess(options, context);
+  return prefix + "_output_prepro";
+}
+
+int main(int argc, const char **argv) {
+  if(argc != 2) {
+    cout << "usage: " << argv[0] << " <tests directory>" << endl;
+    return 1;
+  }
+  string tests = argv[1];
+  const char *tasks[] = {"basic", "numeric"};
+  int failures = 0;
+  for(int i = 0; i < 2; i++) {
+    string input = tests + "/" + tasks[i] + "_output.sas";
+    for(int j = 0; j < sizeof(encodings) / sizeof(encodings[0]); j++) {
+      const Encoding &encoding = encodings[j];
+      string prefix = string(tasks[i]) + "_" + encoding.name;
+      string plain = run(input, prefix + "_plain", encoding, true);
+      string encoded = run(input, prefix, encoding, false);
+      if(decode_output(plain, false) !=
+	 decode_output(encoded, encoding.any_value_transitions) ||
+	 strip_encoded_sections(read_file(plain)) !=
+	 strip_encoded_sections(read_file(encoded))) {
+	cout << "FAILED: " << tasks[i] << ": the " << encoding.name
+	     << " encoding does not decode to the plain output" << endl;
+	failures++;
+      }
+    }
+  }
+
+  // Renumbering the operators permutes the operator section, and the
+  // successor generator and DTGs refer to the operators by their new
+  // numbers.
+  int moved = 0;
+  for(int i = 0; i < 2; i++) {
+    string input = tests + "/" + tasks[i] + "_output.sas";
+    string prefix = string(tasks[i]) + "_";
+    string original = run(input, prefix + "original", original_numbers,
+			  false);
+    string renumbered = run(input, prefix + "renumbered", new_numbers,
+			    false);
+    if(find_original_operators(read_file(original), read_file(renumbered)))
+      moved++;
+    string decoded = decode_output(renumbered, false);
+    // Decoding the original output through the identity sorts its
+    // lists of operators in the same way.
+    for(int j = 0; j < original_operators.size(); j++)
+      original_operators[j] = j;
+    if(decoded != decode_output(original, false)) {
+      cout << "FAILED: " << tasks[i] << ": the renumbered generator or "
+	   << "DTGs differ from the original ones" << endl;
+      failures++;
+    }
+    original_operators.clear();
+  }
+  if(moved == 0) {
+    cout << "FAILED: renumbering moved no operators" << endl;
+    failures++;
+  }
+
+  // The switch order only changes the shape of the successor
+  // generator, not the operators it returns in a state.
+  for(int i = 0; i < 2; i++) {
+    string input = tests + "/" + tasks[i] + "_output.sas";
+    string index = run_in_order(input, string(tasks[i]) + "_index",
+				SWITCH_ORDER_INDEX);
+    string cost = run_in_order(input, string(tasks[i]) + "_cost",
+			       SWITCH_ORDER_COST);
+    int differing = count_differing_states(index, cost);
+    if(differing != 0) {
+      cout << "FAILED: " << tasks[i] << ": the cost order returns other "
+	   << "operators than the index order in " << differing
+	   << " states" << endl;
+      failures++;
+    }
+  }
+
+  // The tasks must exercise every encoding.
+  if(counts.empty_runs == 0 || counts.dense_lists == 0 ||
+     counts.sparse_lists == 0 || counts.bitmap_lists == 0 ||
+     counts.operator_ranges == 0 || counts.any_value_transitions == 0) {
+    cout << "FAILED: the tasks do not use every encoding" << endl;
+    failures++;
+  }
+  if(failures != 0)
+    return 1;
+  cout << "output encoding tests passed" << endl;
+  return 0;
+}
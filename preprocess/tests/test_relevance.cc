@@ -0,0 +1,117 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+/* Computes the relevant variables for several goal sets in one sweep
+ * of CausalGraph::calculate_relevance, and checks every goal set
+ * against a sweep for it alone. The numbers of goal sets cross the
+ * boundaries of the words of lanes. Called with the tests directory as
+ * the argument.
+ */
+
+#include "../axiom.h"
+#include "../causal_graph.h"
+#include "../helper_functions.h"
+#include "../operator.h"
+#include "../pipeline_context.h"
+#include "../state.h"
+#include "../tokenizer.h"
+#include "../variable.h"
+
+#include <climits>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Goal set k of a task with the given number of variables: variable
+// k % variable_count and, for odd k, a second one. Goal set 0 is empty.
+static vector<int> make_goal_set(int k, int variable_count) {
+  vector<int> goal_set;
+  if(k == 0)
+    return goal_set;
+  goal_set.push_back(k % variable_count);
+  if(k % 2 == 1)
+    goal_set.push_back((3 * k + 1) % variable_count);
+  return goal_set;
+}
+
+int main(int argc, const char **argv) {
+  if(argc != 2) {
+    cout << "usage: " << argv[0] << " <tests directory>" << endl;
+    return 1;
+  }
+  string input = string(argv[1]) + "/numeric_output.sas";
+  PipelineContext context;
+  context.set_do_not_prune_variables(true);
+  string metric;
+  vector<Variable *> variables;
+  vector<Variable> internal_variables;
+  State initial_state;
+  vector<pair<Variable *, int> > goals;
+  OperatorTable operators(context.get_strings(), context.get_conditions());
+  vector<Axiom> axioms;
+  vector<Variable *> shared_vars;
+  vector<int> shared_vars_number;
+
+  Tokenizer in(input.c_str());
+  in.read_string(); // name
+  read_preprocessed_problem_description
+    (context, in, metric, internal_variables, variables, initial_state,
+     goals, operators, axioms, shared_vars, shared_vars_number);
+  context.set_variable_count(variables.size());
+  CausalGraph causal_graph(context, variables, operators, axioms, goals);
+
+  const int lane_bits = sizeof(unsigned long) * CHAR_BIT;
+  const int goal_set_counts[] = {1, 2, lane_bits + 1, 2 * lane_bits + 3};
+  int failures = 0;
+  for(int c = 0; c < sizeof(goal_set_counts) / sizeof(int); c++) {
+    int count = goal_set_counts[c];
+    vector<vector<int> > goal_sets;
+    for(int k = 0; k < count; k++)
+      goal_sets.push_back(make_goal_set(k, variables.size()));
+    vector<unsigned long> relevant;
+    causal_graph.calculate_relevance(goal_sets, relevant);
+    int words = (count + lane_bits - 1) / lane_bits;
+    if(relevant.size() != variables.size() * words) {
+      cout << "FAILED: " << count << " goal sets: wrong number of words"
+	   << endl;
+      failures++;
+      continue;
+    }
+
+    for(int k = 0; k < count; k++) {
+      vector<vector<int> > single(1, goal_sets[k]);
+      vector<unsigned long> expected;
+      causal_graph.calculate_relevance(single, expected);
+      for(int var = 0; var < variables.size(); var++) {
+	unsigned long word = relevant[var * words + k / lane_bits];
+	bool lane = (word >> (k % lane_bits)) & 1;
+	if(lane != (expected[var] != 0)) {
+	  cout << "FAILED: " << count << " goal sets: goal set " << k
+	       << ", variable " << var << endl;
+	  failures++;
+	}
+      }
+    }
+  }
+  if(failures != 0)
+    return 1;
+  cout << "relevance tests passed" << endl;
+  return 0;
+}
@@ -0,0 +1,268 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+/* Tests for the tokenizer: tokens that end exactly at the end of the
+ * mapped file or of a section, empty files, inputs that end in the
+ * middle of what is being read, which must be reported and terminate
+ * the program instead of reading past the data, and input streamed
+ * from a pipe.
+ */
+
+#include "../tokenizer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+using namespace std;
+
+static int failures = 0;
+
+static void check(bool condition, const char *what) {
+  if(!condition) {
+    cout << "FAILED: " << what << endl;
+    failures++;
+  }
+}
+
+static void write_file(const char *filename, const string &content) {
+  ofstream out(filename, ios::out | ios::binary);
+  out << content;
+}
+
+// Pads the content with leading blanks so the file fills exactly one
+// page, and the last token ends at the end of the mapping.
+static void write_page_file(const char *filename, const string &content) {
+  size_t page_size = sysconf(_SC_PAGESIZE);
+  write_file(filename, string(page_size - content.size(), ' ') + content);
+}
+
+// Runs the test in a child process and checks that it terminated the
+// program with exit code 1.
+static void check_exits(void (*test)(const char *), const char *filename,
+			const char *what) {
+  cout.flush();
+  pid_t pid = fork();
+  if(pid == 0) {
+    int null_fd = open("/dev/null", O_WRONLY);
+    dup2(null_fd, 1);
+    test(filename);
+    _exit(0);
+  }
+  int status;
+  waitpid(pid, &status, 0);
+  check(WIFEXITED(status) && WEXITSTATUS(status) == 1, what);
+}
+
+static void test_int_at_end_of_mapping() {
+  write_page_file("int.txt", "begin 42\n-12345");
+  Tokenizer in("int.txt");
+  in.check_magic("begin");
+  check(in.read_int() == 42, "int before the last token");
+  check(in.read_int() == -12345, "int at the end of the mapping");
+  check(in.at_end(), "at end after the last int");
+}
+
+static void test_float_at_end_of_mapping() {
+  write_page_file("float.txt", "1.5 2.25");
+  Tokenizer in("float.txt");
+  check(in.read_float() == 1.5, "float before the last token");
+  check(in.read_float() == 2.25, "float at the end of the mapping");
+  check(in.at_end(), "at end after the last float");
+}
+
+static void test_words_at_end_of_mapping() {
+  write_page_file("words.txt", "begin_goal\nend_goal");
+  Tokenizer in("words.txt");
+  in.check_magic("begin_goal");
+  const char *token;
+  size_t length;
+  in.read_token(token, length);
+  check(in.token_equals(token, length, "end_goal"),
+	"token at the end of the mapping");
+  check(!in.token_equals(token, length, "end_goals"),
+	"token is not a prefix of a longer word");
+  check(in.at_end(), "at end after the last token");
+
+  Tokenizer again("words.txt");
+  again.skip_past("end_goal");
+  check(again.at_end(), "skip_past a word at the end of the mapping");
+}
+
+static void test_line_at_end_of_mapping() {
+  write_page_file("line.txt", "first line\nlast line");
+  Tokenizer in("line.txt");
+  check(in.read_line() == "first line", "line before the last line");
+  check(in.read_line() == "last line",
+	"line without newline at the end of the mapping");
+  check(in.at_end(), "at end after the last line");
+}
+
+static void test_section_boundaries() {
+  // The parser threads read sections that end in the middle of the
+  // file; a token must not run past the end of its section.
+  string text = "12 345 end_operator_x";
+  Tokenizer in(text.data(), text.data() + 5);
+  check(in.read_int() == 12, "int inside a section");
+  check(in.read_int() == 34, "int cut at the end of a section");
+  check(in.at_end(), "at end of a section");
+
+  Tokenizer words(text.data() + 7, text.data() + 19);
+  words.skip_past("end_operator");
+  check(words.at_end(), "skip_past a word at the end of a section");
+}
+
+static void test_empty_files() {
+  write_file("empty.txt", "");
+  Tokenizer empty("empty.txt");
+  check(empty.at_end(), "empty file is at end");
+  check(!empty.has_prefix("SAS", 3), "empty file has no prefix");
+
+  write_file("blank.txt", " \n\t\n");
+  Tokenizer blank("blank.txt");
+  check(blank.at_end(), "file with only whitespace is at end");
+}
+
+static void read_two_ints(const char *filename) {
+  Tokenizer in(filename);
+  in.read_int();
+  in.read_int();
+}
+
+static void read_magic_after_int(const char *filename) {
+  Tokenizer in(filename);
+  in.read_int();
+  in.check_magic("end_state");
+}
+
+static void skip_past_missing_word(const char *filename) {
+  Tokenizer in(filename);
+  in.skip_past("end_operator");
+}
+
+static void test_truncated_files() {
+  check_exits(read_two_ints, "empty.txt", "int from an empty file");
+  write_file("one_int.txt", "7");
+  check_exits(read_two_ints, "one_int.txt", "int behind the end of a file");
+  write_file("cut_magic.txt", "7\nend_sta");
+  check_exits(read_magic_after_int, "cut_magic.txt",
+	      "magic word cut at the end of a file");
+  write_page_file("cut_page.txt", "7\nend_operat");
+  check_exits(skip_past_missing_word, "cut_page.txt",
+	      "skip_past a word cut at the end of the mapping");
+}
+
+static void write_all(int fd, const string &data) {
+  size_t written = 0;
+  while(written < data.size()) {
+    ssize_t bytes = write(fd, data.data() + written, data.size() - written);
+    if(bytes <= 0)
+      _exit(1);
+    written += bytes;
+  }
+}
+
+// Writes the pieces to the pipe with pauses in between, so tokens are
+// split across reads.
+static void write_pieces(int fd, const char **pieces) {
+  struct timespec pause = {0, 20000000};
+  for(int i = 0; pieces[i]; i++) {
+    write_all(fd, pieces[i]);
+    nanosleep(&pause, 0);
+  }
+}
+
+// Reads from a pipe on stdin, which is how preprocess reads "-".
+// Besides the split tokens, the input is larger than the initial
+// buffer so the streaming tokenizer has to refill and grow it.
+static void test_pipe_input() {
+  const int number_count = 300000;
+  int fds[2];
+  if(pipe(fds) != 0) {
+    check(false, "create a pipe");
+    return;
+  }
+  cout.flush();
+  pid_t pid = fork();
+  if(pid == 0) {
+    close(fds[0]);
+    const char *pieces[] = {"begin_state\n12", "345 2.", "5 end_st",
+			    "ate\nfirst line\nlast", " line\n", 0};
+    write_pieces(fds[1], pieces);
+    string numbers;
+    for(int i = 0; i < number_count; i++)
+      numbers += "1234567\n";
+    write_all(fds[1], numbers);
+    write_all(fds[1], "end");
+    _exit(0);
+  }
+  close(fds[1]);
+  int saved_stdin = dup(0);
+  dup2(fds[0], 0);
+  close(fds[0]);
+  {
+    Tokenizer in("-");
+    in.check_magic("begin_state");
+    check(in.read_int() == 12345, "int split across pipe reads");
+    check(in.read_float() == 2.5, "float split across pipe reads");
+    in.check_magic("end_state");
+    check(in.read_line() == "first line", "line from a pipe");
+    check(in.read_line() == "last line", "line split across pipe reads");
+    check(in.read_int() == 1234567, "int from a pipe");
+    in.load_remaining();
+    size_t rest = (number_count - 1) * 8 + 4;
+    check(size_t(in.data_end() - in.position()) == rest,
+	  "load_remaining reads the rest of the pipe");
+    bool all_read = true;
+    for(int i = 1; i < number_count; i++)
+      all_read = all_read && in.read_int() == 1234567;
+    check(all_read, "ints after load_remaining");
+    in.check_magic("end");
+    check(in.at_end(), "at end of the pipe");
+  }
+  check(fcntl(0, F_GETFD) != -1, "stdin stays open");
+  dup2(saved_stdin, 0);
+  close(saved_stdin);
+  int status;
+  waitpid(pid, &status, 0);
+  check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "pipe writer");
+}
+
+int main() {
+  test_int_at_end_of_mapping();
+  test_float_at_end_of_mapping();
+  test_words_at_end_of_mapping();
+  test_line_at_end_of_mapping();
+  test_section_boundaries();
+  test_empty_files();
+  test_truncated_files();
+  test_pipe_input();
+  if(failures != 0) {
+    cout << failures << " tokenizer checks failed." << endl;
+    return 1;
+  }
+  cout << "tokenizer tests passed" << endl;
+  return 0;
+}
@@ -0,0 +1,322 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+// Needed for files > 2 GB on 32-bit systems; must precede all includes.
+#ifndef _FILE_OFFSET_BITS
+#define _FILE_OFFSET_BITS 64
+#endif
+
+#include "tokenizer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+using namespace std;
+
+static inline bool is_space(char c) {
+  return c == ' ' || c == '\n' || c == '\t' || c == '\r' ||
+    c == '\v' || c == '\f';
+}
+
+Tokenizer::Tokenizer(const char *filename)
+  : pos(0), end(0), mapped_data(0), mapped_size(0),
+    fd(-1), buffer(0), capacity(0) {
+  open_file(filename);
+}
+
+Tokenizer::Tokenizer(const char *begin, const char *end_)
+  : pos(begin), end(end_), mapped_data(0), mapped_size(0),
+    fd(-1), buffer(0), capacity(0) {
+}
+
+Tokenizer::~Tokenizer() {
+  if(mapped_data)
+    munmap(const_cast<char *>(mapped_data), mapped_size);
+  // fd 0 is stdin, which stays open (see tokenizer.h).
+  if(fd > 0)
+    close(fd);
+  free(buffer);
+}
+
+void Tokenizer::open_file(const char *filename) {
+  int file = 0;
+  if(strcmp(filename, "-") != 0)
+    file = open(filename, O_RDONLY);
+  if(file == -1) {
+    cout << "Could not open input file '" << filename << "': "
+	 << strerror(errno) << endl;
+    exit(1);
+  }
+  struct stat file_stat;
+  if(fstat(file, &file_stat) == 0 && S_ISREG(file_stat.st_mode) &&
+     file_stat.st_size > 0) {
+    mapped_size = file_stat.st_size;
+    void *data = mmap(0, mapped_size, PROT_READ, MAP_PRIVATE, file, 0);
+    if(data != MAP_FAILED) {
+      madvise(data, mapped_size, MADV_SEQUENTIAL);
+      mapped_data = static_cast<const char *>(data);
+      pos = mapped_data;
+      end = mapped_data + mapped_size;
+      if(file > 0)
+	close(file);
+      return;
+    }
+    mapped_size = 0;
+  }
+  fd = file;
+  capacity = 1 << 20;
+  buffer = static_cast<char *>(malloc(capacity));
+  pos = end = buffer;
+}
+
+/* Reads more input behind end. Unless keep_consumed is set, the data
+   before pos is dropped first to make room, which moves the unread
+   data (and pos) to the start of the buffer. Returns false if there
+   is nothing more to read. */
+bool Tokenizer::fill(bool keep_consumed) {
+  if(fd == -1)
+    return false;
+  if(!keep_consumed && pos != buffer) {
+    size_t unread = end - pos;
+    memmove(buffer, pos, unread);
+    pos = buffer;
+    end = buffer + unread;
+  }
+  size_t size = end - buffer;
+  if(size == capacity) {
+    size_t offset = pos - buffer;
+    capacity *= 2;
+    buffer = static_cast<char *>(realloc(buffer, capacity));
+    pos = buffer + offset;
+    end = buffer + size;
+  }
+  while(true) {
+    ssize_t bytes = read(fd, buffer + size, capacity - size);
+    if(bytes > 0) {
+      end += bytes;
+      return true;
+    }
+    if(bytes < 0 && errno == EINTR)
+      continue;
+    if(bytes < 0) {
+      cout << "Error reading input: " << strerror(errno) << endl;
+      exit(1);
+    }
+    if(fd > 0)
+      close(fd);
+    fd = -1;
+    return false;
+  }
+}
+
+void Tokenizer::load_remaining() {
+  while(fill(true)) {
+  }
+}
+
+bool Tokenizer::has_prefix(const char *bytes, size_t length) {
+  while(end - pos < length)
+    if(!fill())
+      return false;
+  return memcmp(pos, bytes, length) == 0;
+}
+
+void Tokenizer::fail(const char *expected) {
+  size_t length = token_length();
+  cout << "Failed to read " << expected << " from input." << endl;
+  cout << "Got '" << string(pos, length) << "'." << endl;
+  exit(1);
+}
+
+void Tokenizer::skip_whitespace() {
+  while(true) {
+    while(pos != end && is_space(*pos))
+      ++pos;
+    if(pos != end || !fill())
+      return;
+  }
+}
+
+bool Tokenizer::at_end() {
+  skip_whitespace();
+  return pos == end;
+}
+
+// Skips whitespace and makes sure the whole next token is buffered.
+size_t Tokenizer::token_length() {
+  skip_whitespace();
+  size_t length = 0;
+  while(true) {
+    while(pos + length != end && !is_space(pos[length]))
+      ++length;
+    if(pos + length != end || !fill())
+      return length;
+  }
+}
+
+// Length of the rest of the current line, which is fully buffered.
+size_t Tokenizer::line_length() {
+  size_t length = 0;
+  while(true) {
+    const char *line_end = static_cast<const char *>(
+      memchr(pos + length, '\n', end - pos - length));
+    if(line_end)
+      return line_end - pos;
+    length = end - pos;
+    if(!fill())
+      return length;
+  }
+}
+
+void Tokenizer::read_token(const char *&token, size_t &length) {
+  length = token_length();
+  token = pos;
+  pos += length;
+}
+
+bool Tokenizer::token_equals(const char *token, size_t length,
+			     const char *word) const {
+  return strncmp(token, word, length) == 0 && word[length] == '\0';
+}
+
+void Tokenizer::skip_token() {
+  const char *token;
+  size_t length;
+  read_token(token, length);
+}
+
+int Tokenizer::read_int() {
+  size_t length = token_length();
+  const char *p = pos;
+  const char *token_end = pos + length;
+  bool negative = false;
+  if(p != token_end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-');
+    ++p;
+  }
+  if(p == token_end || *p < '0' || *p > '9')
+    fail("an integer");
+  long value = 0;
+  while(p != token_end && *p >= '0' && *p <= '9')
+    value = value * 10 + (*p++ - '0');
+  pos = p;
+  return negative ? -value : value;
+}
+
+size_t Tokenizer::parse_float(const char *token, size_t length,
+			      float &value) {
+  // strtof needs a terminated string; numbers are short, so a local
+  // buffer avoids touching the heap.
+  char buffer[64];
+  if(length == 0 || length >= sizeof(buffer))
+    return 0;
+  memcpy(buffer, token, length);
+  buffer[length] = '\0';
+  char *number_end;
+  float parsed = strtof(buffer, &number_end);
+  if(number_end == buffer)
+    return 0;
+  value = parsed;
+  return number_end - buffer;
+}
+
+float Tokenizer::read_float() {
+  size_t length = token_length();
+  float value = 0;
+  size_t used = parse_float(pos, length, value);
+  if(used == 0)
+    fail("a number");
+  // Like "istream >>", only consume the characters that were parsed.
+  pos += used;
+  return value;
+}
+
+bool Tokenizer::read_bool() {
+  return read_int() != 0;
+}
+
+string Tokenizer::read_string() {
+  const char *token;
+  size_t length;
+  read_token(token, length);
+  return string(token, length);
+}
+
+string Tokenizer::read_line() {
+  skip_whitespace();
+  size_t length = line_length();
+  string line(pos, length);
+  pos += length;
+  if(pos != end)
+    ++pos; // newline
+  return line;
+}
+
+void Tokenizer::read_line(const char *&line, size_t &length) {
+  skip_whitespace();
+  length = line_length();
+  line = pos;
+  pos += length;
+  if(pos != end)
+    ++pos; // newline
+}
+
+void Tokenizer::check_magic(const char *magic) {
+  const char *word;
+  size_t length;
+  read_token(word, length);
+  if(!token_equals(word, length, magic)) {
+    cout << "Failed to match magic word '" << magic << "'." << endl;
+    cout << "Got '" << string(word, length) << "'." << endl;
+    exit(1);
+  }
+}
+
+void Tokenizer::skip_line() {
+  pos += line_length();
+  if(pos != end)
+    ++pos; // newline
+}
+
+void Tokenizer::skip_past(const char *word) {
+  size_t length = strlen(word);
+  const char *start = pos;
+  while(true) {
+    const char *found = search(start, end, word, word + length);
+    if(found == end) {
+      pos = end;
+      cout << "Failed to find magic word '" << word << "'." << endl;
+      exit(1);
+    }
+    const char *found_end = found + length;
+    if((found == pos || is_space(found[-1])) &&
+       (found_end == end || is_space(*found_end))) {
+      pos = found_end;
+      return;
+    }
+    start = found + 1;
+  }
+}
@@ -0,0 +1,111 @@
+/*********************************************************************
+ *
+ * This file is part of LAMA.
+ *
+ * LAMA is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 3
+ * of the license, or (at your option) any later version.
+ *
+ * LAMA is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ *
+ *********************************************************************/
+
+#ifndef TOKENIZER_H
+#define TOKENIZER_H
+
+/*
+  Whitespace tokenizer for the output.sas files written by translate.
+
+  Regular files are memory-mapped and scanned in place, so integers,
+  floats and magic words are parsed without allocating a string for
+  every token. Positions are kept as pointers and sizes as size_t, so
+  files larger than 2 GB are fine on 64-bit systems.
+
+  Inputs that cannot be mapped (stdin, pipes, FIFOs) are streamed: the
+  buffer is refilled whenever parsing reaches the end of the data read
+  so far, so preprocessing can start while translate is still writing.
+  In this mode a token returned by read_token() is only valid until
+  the next read; load_remaining() reads the rest of the input, after
+  which the buffer no longer moves.
+
+  A tokenizer can also be opened on a part of another tokenizer's
+  buffer (see position() and skip_past()); this is how sections are
+  handed to worker threads for parallel parsing.
+
+  The read_* methods follow the semantics of the corresponding
+  "istream >>" extractions they replace; read_line() behaves like
+  "in >> ws; getline(in, line)". Malformed input is reported on cout
+  and terminates the program, like check_magic always did.
+*/
+
+#include <cstddef>
+#include <string>
+using namespace std;
+
+class Tokenizer {
+  const char *pos;
+  const char *end;
+
+  const char *mapped_data; // non-null if the input is an mmap
+  size_t mapped_size;
+
+  // Streaming input; fd is -1 once the end of the input is reached.
+  // Descriptor 0 belongs to the process, so stdin is never closed.
+  int fd;
+  char *buffer;
+  size_t capacity;
+
+  void open_file(const char *filename);
+  bool fill(bool keep_consumed = false);
+  size_t token_length();
+  size_t line_length();
+  void fail(const char *expected);
+
+  // forbid copying: we own the mapping
+  Tokenizer(const Tokenizer &copy);
+  Tokenizer &operator=(const Tokenizer &copy);
+public:
+  // "-" reads from stdin.
+  explicit Tokenizer(const char *filename);
+  Tokenizer(const char *begin, const char *end);
+  ~Tokenizer();
+
+  void skip_whitespace();
+  bool at_end();
+
+  // Token boundaries without copying.
+  void read_token(const char *&token, size_t &length);
+  bool token_equals(const char *token, size_t length, const char *word) const;
+  void skip_token();
+  // Parses the leading number of a token, returning the number of
+  // characters used (0 if the token does not start with a number).
+  static size_t parse_float(const char *token, size_t length, float &value);
+
+  int read_int();
+  float read_float();
+  bool read_bool();
+  string read_string();
+  string read_line();
+  void read_line(const char *&line, size_t &length);
+  void check_magic(const char *magic);
+
+  void load_remaining();
+  // Compares the very first bytes of the unread input, without
+  // skipping whitespace.
+  bool has_prefix(const char *bytes, size_t length);
+  const char *position() const {return pos;}
+  const char *data_end() const {return end;}
+  void skip_line();
+  // Moves behind the next occurrence of word as a whole token. Only
+  // looks at buffered data, so call load_remaining() first.
+  void skip_past(const char *word);
+};
+
+#endif
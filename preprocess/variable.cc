@@ -21,28 +21,36 @@
  *********************************************************************/
 
 #include "variable.h"
+#include "tokenizer.h"
+#include "sas_binary.h"
+#include "string_table.h"
 
-#include <cassert>
 using namespace std;
 
-Variable::Variable(istream &in) {
-  in >> name >> range >> layer >> isTotalTime;
-  level = -1;
-  necessary = false;
+Variable::Variable(Tokenizer &in, StringTable &the_strings, int the_index)
+  : index(the_index), strings(&the_strings) {
+  const char *name;
+  size_t name_length;
+  in.read_token(name, name_length);
+  name_id = the_strings.intern(name, name_length);
+  range = in.read_int();
+  layer = in.read_int();
+  isTotalTime = in.read_bool();
 }
 
-void Variable::set_level(int theLevel) {
-  assert(level == -1);
-  level = theLevel;
+Variable::Variable(BinaryReader &in, int the_index)
+  : index(the_index), strings(&in.get_string_table()) {
+  name_id = in.read_string_id();
+  range = in.read_uint();
+  layer = in.read_int();
+  isTotalTime = in.read_bool();
 }
 
-int Variable::get_level() const {
-  return level;
-}
-
-void Variable::set_necessary() {
-  assert(necessary == false);
-  necessary = true;
+void Variable::write_binary(BinaryWriter &out) const {
+  out.write_string_id(name_id);
+  out.write_uint(range);
+  out.write_int(layer);
+  out.write_bool(isTotalTime);
 }
 
 int Variable::get_range() const {
@@ -50,11 +58,7 @@ int Variable::get_range() const {
 }
 
 string Variable::get_name() const {
-  return name;
-}
-
-bool Variable::is_necessary() const {
-  return necessary;
+  return strings->get(name_id);
 }
 
 bool Variable::get_isTotalTime() const{
@@ -66,9 +70,7 @@ void Variable::set_isTotalTime(bool theisTotalTime) {
 }
 
 void Variable::dump() const {
-  cout << name << " [range " << range;
-  if(level != -1)
-    cout << "; level " << level;
+  cout << get_name() << " [range " << range;
   if(is_derived())
     cout << "; derived; layer: "<< layer;
   cout << "]" << endl;
@@ -26,23 +26,28 @@
 #include <iostream>
 using namespace std;
 
+class BinaryReader;
+class BinaryWriter;
+class StringTable;
+class Tokenizer;
+
 class Variable {
+  int index; // position in the translator's variable list
   int range;
-  string name;
+  const StringTable *strings;
+  int name_id; // in strings
   int layer;
-  int level;
-  bool necessary;
   bool isTotalTime;
 public:
-  Variable(istream &in);
-  void set_level(int level);
-  void set_necessary(); 
+  Variable(Tokenizer &in, StringTable &strings, int index);
+  Variable(BinaryReader &in, int index);
+  void write_binary(BinaryWriter &out) const;
   void set_isTotalTime(bool theisTotalTime);
   bool get_isTotalTime() const;
-  int get_level() const;
-  bool is_necessary() const; 
+  int get_index() const {return index;}
   int get_range() const;
   string get_name() const;
+  int get_name_id() const {return name_id;}
   int get_layer() const {return layer;}
   bool is_derived() const {return layer != -1;}
   void dump() const;